@@ -0,0 +1,106 @@
+#include "tqdm.h"
+
+// microbenchmark comparing the line renderer used by tqdm_update against the
+// snprintf-based line assembly it replaced, on the same bar state
+//
+// build and run with: cc -O2 -o bench bench.c && ./bench
+
+#define ITERATIONS 5000000
+#define WIDTH 160
+
+// the previous snprintf implementation of time formatting
+static void format_time_snprintf(double milliseconds, char *buffer, size_t n) {
+    int total_seconds = (int)(milliseconds / 1000 + 0.5);
+    int h = total_seconds / 3600;
+    int m = (total_seconds % 3600) / 60;
+    int s = total_seconds % 60;
+
+    if (h > 0) {
+        snprintf(buffer, n, "%02d:%02d:%02d", h, m, s);
+    } else {
+        snprintf(buffer, n, "%02d:%02d", m, s);
+    }
+}
+
+// the previous line assembly of tqdm_update, up to the write
+static size_t render_snprintf(const tqdm *t, uint64_t steps, long now_ms, unsigned int width, char *out) {
+    double elapsed = now_ms - t->_start;
+    double iter_per_ms = steps / (elapsed + 1e-9);
+    double percent_complete = (double)steps / t->total_steps;
+    double remaining = (iter_per_ms > 0 && steps < t->total_steps)
+                        ? (t->total_steps - steps) / iter_per_ms
+                        : 0;
+
+    char elapsed_str[32], remaining_str[32];
+    format_time_snprintf(elapsed, elapsed_str, sizeof(elapsed_str));
+    format_time_snprintf(remaining, remaining_str, sizeof(remaining_str));
+
+    // the cursor movement before the line is left out, as _tqdm_render doesn't produce it
+    char bar[1024];
+    int before_bar_length = snprintf(bar, sizeof(bar), "%s%s%3.0f%% |",
+                                     t->description, t->_after_description, percent_complete * 100);
+    int bar_pos = before_bar_length;
+
+    char after_bar[128];
+    int after_bar_length = snprintf(after_bar, sizeof(after_bar), "| %llu/%llu [%s<%s, %.2fit/s]",
+                                    (unsigned long long)steps, (unsigned long long)t->total_steps,
+                                    elapsed_str, remaining_str, iter_per_ms * 1000.0);
+
+    unsigned int nonbar_width = before_bar_length + after_bar_length;
+    int bar_width = MAX((int)(width - nonbar_width), TQDM_MINIMUM_BAR_WIDTH);
+    double filled_cells = percent_complete * bar_width;
+    int full_cells = (int)filled_cells;
+    double fractional_cell = filled_cells - full_cells;
+
+    for (int i = 0; i < bar_width; i++) {
+        ssize_t idx = TQDM_EMPTY_IDX;
+        if (i < full_cells) {
+            idx = TQDM_FULL_IDX;
+        } else if (i == full_cells) {
+            idx = (ssize_t)(fractional_cell * 8);
+        }
+
+        const char *block = TQDM_BLOCKS[idx];
+        memcpy(bar + bar_pos, block, strlen(block));
+        bar_pos += strlen(block);
+    }
+    bar[bar_pos] = 0;
+
+    return snprintf(out, TQDM_MAXIMUM_LINE_SIZE, "%s%s", bar, after_bar);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main() {
+    char line[TQDM_MAXIMUM_LINE_SIZE];
+    uint64_t total = 123456789012ULL;
+    size_t checksum = 0;
+
+    // both renderers see the same bar, with the rate averaged over the run as before
+    tqdm bar;
+    tqdm_init(&bar, total, "Benchmarking", 0);
+    bar.eta_model = &tqdm_eta_average;
+    bar._start = 0;
+
+    double start = now_ns();
+    for (uint64_t i = 0; i < ITERATIONS; i++) {
+        checksum += render_snprintf(&bar, i * 24691, (long)(i * 3.7) + 1, WIDTH, line);
+    }
+    double snprintf_ns = (now_ns() - start) / ITERATIONS;
+
+    start = now_ns();
+    for (uint64_t i = 0; i < ITERATIONS; i++) {
+        checksum += _tqdm_render(&bar, i * 24691, (long)(i * 3.7) + 1, WIDTH, line);
+    }
+    double render_ns = (now_ns() - start) / ITERATIONS;
+
+    printf("snprintf:  %7.1f ns/frame\n", snprintf_ns);
+    printf("render:    %7.1f ns/frame\n", render_ns);
+    printf("speedup:   %7.1fx\n", snprintf_ns / render_ns);
+    printf("(checksum %zu)\n", checksum);
+    return 0;
+}
@@ -41,6 +41,8 @@ extern "C" {
 #include <string.h>
 #include <stdbool.h>
 #include <signal.h>
+#include <sched.h>
+#include <sys/mman.h>
 
 /**
  * @brief Feature toggle for dynamically resizing the progress bar based on terminal width.
@@ -51,11 +53,87 @@ extern "C" {
 #define TQDM_DYNAMIC_RESIZE 1
 #endif
 
+/**
+ * @brief Feature toggle for features that run a background thread, such as tqdm_renderer.
+ * Set to 1 to enable them (requires pthreads), 0 to leave them out (default).
+ */
+#ifndef TQDM_THREADS
+#define TQDM_THREADS 0
+#endif
+
+#if TQDM_THREADS
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif // TQDM_THREADS
+
+/**
+ * @brief Feature toggle for compiling tqdm out entirely.
+ * Set to 1 to turn all tqdm functions and loop macros into no-ops that the
+ * optimiser removes, 0 to build progress bars normally (default).
+ */
+#ifndef TQDM_DISABLE
+#define TQDM_DISABLE 0
+#endif
+
+/**
+ * @brief Feature toggle for disabling progress bars that are not written to a terminal.
+ * Set to 1 to stop drawing a bar whose file descriptor is not a terminal (default),
+ * 0 to always draw. A disabled bar still counts steps, but updates skip the clock entirely.
+ */
+#ifndef TQDM_AUTO_DISABLE
+#define TQDM_AUTO_DISABLE 1
+#endif
+
+/**
+ * @brief Feature toggle for redrawing only the changed part of the progress bar.
+ * Set to 1 to move the cursor past the unchanged start of the line and write only
+ * the rest, 0 to rewrite the whole line whenever it changes (default).
+ * Unchanged lines are never rewritten.
+ */
+#ifndef TQDM_PARTIAL_REDRAW
+#define TQDM_PARTIAL_REDRAW 0
+#endif
+
+/**
+ * @brief Feature toggle for publishing every progress bar to a machine-wide registry.
+ * Set to 1 to publish the state of each bar to a shared-memory segment under /dev/shm,
+ * where tqdm_top can display it, 0 to keep bars private to the process (default).
+ * Bars that are not written to a terminal are still published, and bars abandoned short
+ * of their total stay published until closed.
+ */
+#ifndef TQDM_REGISTRY
+#define TQDM_REGISTRY 0
+#endif
+
+#if TQDM_REGISTRY
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#endif // TQDM_REGISTRY
+
+/**
+ * @brief Feature toggle for measuring the time each progress bar spends inside tqdm.
+ * Set to 1 to time every update that reads the clock and every redraw done elsewhere
+ * (e.g. by a renderer thread), and show the total as a share of the elapsed time,
+ * 0 to leave the measurement out (default).
+ * Updates on the fast path are never timed, so they stay a single add and compare.
+ */
+#ifndef TQDM_MEASURE_OVERHEAD
+#define TQDM_MEASURE_OVERHEAD 0
+#endif
+
 #define TQDM_DEFAULT_TERMINAL_WIDTH 80
 #define TQDM_MINIMUM_TERMINAL_WIDTH 10
 #define TQDM_MAXIMUM_TERMINAL_WIDTH 1024
 #define TQDM_MINIMUM_BAR_WIDTH 1
 
+/// total_steps of a bar whose total is not known, which is drawn without a percentage or bar
+#define TQDM_UNKNOWN_TOTAL UINT64_MAX
+
 static const char *TQDM_BLOCKS[] = {
     " ",                // ' '
     "\xE2\x96\x8F",     // '▏'
@@ -71,17 +149,59 @@ static const char *TQDM_BLOCKS[] = {
 #define TQDM_EMPTY_IDX  0
 #define TQDM_FULL_IDX   8
 
+/// number of bytes in each non-empty block character
+#define TQDM_BLOCK_BYTES 3
+
+/// maximum length of a rendered line: description, block characters and counters
+#define TQDM_MAXIMUM_LINE_SIZE (TQDM_MAXIMUM_TERMINAL_WIDTH * (TQDM_BLOCK_BYTES + 1) + 256)
+
+/// maximum number of steps between clock reads of a bar with an adaptive stride, which bounds
+/// how long it can go without redrawing after its rate drops suddenly
+#ifndef TQDM_MAXIMUM_STRIDE
+#define TQDM_MAXIMUM_STRIDE 1024
+#endif
+
+/// number of redraws the windowed ETA model fits its rate over
+#ifndef TQDM_ETA_WINDOW
+#define TQDM_ETA_WINDOW 16
+#endif
+
+#define _TQDM_REPEAT_4(s) s s s s
+#define _TQDM_REPEAT_1024(s) _TQDM_REPEAT_4(_TQDM_REPEAT_4(_TQDM_REPEAT_4(_TQDM_REPEAT_4(_TQDM_REPEAT_4(s)))))
+
+/// precomputed runs of full blocks and spaces, long enough for the widest terminal
+static const char _tqdm_full_run[] = _TQDM_REPEAT_1024("\xE2\x96\x88");
+static const char _tqdm_space_run[] = _TQDM_REPEAT_1024(" ");
+
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 #define CLAMP(x, low, high) (MIN(MAX((x), (low)), (high)))
 
+struct tqdm_manager;
+struct tqdm;
+struct tqdm_registry;
+
+/**
+ * @brief Struct representing a model estimating the rate, and thus the remaining time, of a bar
+ *
+ * The bar feeds the model a (time, steps) sample on every redraw at which time
+ * has passed, then asks it for the rate to display. Models keep their state in
+ * the bar, so a model can be shared between bars.
+ */
+typedef struct tqdm_eta_model {
+    /// records a sample; the bar's previous sample is still in _rate_steps and _rate_time
+    void (*sample)(struct tqdm *t, uint64_t steps, long now_ms);
+    /// returns the rate in steps per ms, or a negative value if it is not known yet
+    double (*rate)(const struct tqdm *t, uint64_t steps, long now_ms);
+} tqdm_eta_model;
+
 /**
  * @brief Struct representing a tqdm progress bar
  *
  * Contains information on total steps, current progress, description,
  * timing information, and minimum update interval.
  */
-typedef struct {
+typedef struct tqdm {
     /* user-facing */
     /// total number of steps
     uint64_t total_steps;
@@ -91,6 +211,26 @@ typedef struct {
     const char *description;
     /// minimum interval between updates (in milliseconds)
     uint32_t min_interval_ms;
+    /// minimum number of steps between clock reads (0 to adapt to the observed rate)
+    uint64_t miniters;
+    /// model estimating the rate and remaining time (&tqdm_eta_ema by default)
+    const tqdm_eta_model *eta_model;
+    /// weight of the latest redraw in tqdm_eta_ema, from 0 (average over the whole run) to 1
+    float smoothing;
+    /// state for a custom eta_model, unused by the built-in models
+    void *eta_state;
+    /// name of a step, shown in the rate ("it" by default)
+    const char *unit;
+    /// whether counts and rates are scaled to three significant digits with an SI or IEC prefix
+    bool unit_scale;
+    /// factor between successive prefixes when scaling: 1000 for SI (default), 1024 for IEC
+    uint32_t unit_divisor;
+    /// whether a bar drawn by a manager stays on screen once done
+    bool leave;
+    /// file descriptor to write JSON-lines progress records to, or -1 for none (default)
+    int json_fd;
+    /// minimum interval between JSON-lines records (in milliseconds)
+    uint32_t json_interval_ms;
 
     /* for internal bookkeeping */
     /// internal string to append after description ("" if no description)
@@ -99,31 +239,101 @@ typedef struct {
     long _start;
     /// time in ms when the progress bar was last printed, based on CLOCK_MONOTONIC
     long _last_print;
+    /// time in ms when the clock was last read, based on CLOCK_MONOTONIC
+    long _last_check;
+    /// time in ms when the last JSON-lines record was written, based on CLOCK_MONOTONIC
+    long _json_last;
+    /// step count when the clock was last read
+    uint64_t _last_check_steps;
+    /// step count at which the clock is next read
+    uint64_t _next_check;
+    /// number of steps between clock reads learned in adaptive mode
+    uint64_t _miniters;
+    /// step count when the rate was last sampled
+    uint64_t _rate_steps;
+    /// time in ms when the rate was last sampled, based on CLOCK_MONOTONIC
+    long _rate_time;
+    /// exponential moving average of the steps between rate samples
+    double _ema_steps;
+    /// exponential moving average of the time in ms between rate samples
+    double _ema_ms;
+    /// times in ms of the latest rate samples, a ring starting at _window_head
+    long _window_ms[TQDM_ETA_WINDOW];
+    /// step counts of the latest rate samples, a ring starting at _window_head
+    uint64_t _window_steps[TQDM_ETA_WINDOW];
+    /// index of the oldest rate sample in the window
+    unsigned int _window_head;
+    /// number of rate samples in the window
+    unsigned int _window_len;
+    /// sequence number of the state read by tqdm_snapshot, odd while it is being written
+    uint32_t _stats_seq;
+    /// step count at the latest rate sample
+    uint64_t _stats_steps;
+    /// time in ms of the latest rate sample, based on CLOCK_MONOTONIC
+    long _stats_ms;
+    /// rate in steps per ms estimated at the latest rate sample, negative if not known yet
+    double _stats_rate;
     /// internal boolean to track if the bar has been drawn, for \r handling
     bool _drawn;
-    /// internal boolean to track if the bar is done
+    /// internal boolean to track if the bar is done, or parked because nobody sees it
     bool _done;
+    /// internal boolean to track if the bar was completed or closed, unlike _done never set by parking
+    bool _closed;
+    /// internal boolean to track if the bar was disabled because its output is not a terminal
+    bool _disabled;
+    /// render lock taken by the thread redrawing a bar shared between threads
+    int _lock;
     /// file descriptor to write to (STDERR_FILENO by default)
     int _fd;
     /// terminal width
     unsigned int _term_width;
+    /// terminal width the last emitted line was rendered for
+    unsigned int _last_width;
+    /// length of the last emitted line
+    size_t _last_line_len;
+    /// last emitted line, to skip or shorten redraws when little has changed
+    char _last_line[TQDM_MAXIMUM_LINE_SIZE];
+    /// manager drawing this bar as part of a stacked block, or NULL if it draws itself
+    struct tqdm_manager *_manager;
+    /// bar advanced by one step when this bar completes, or NULL
+    struct tqdm *_parent;
+#if TQDM_DYNAMIC_RESIZE
+    /// value of _tqdm_winch when the terminal width was last queried
+    sig_atomic_t _winch_seen;
+#endif // TQDM_DYNAMIC_RESIZE
+#if TQDM_REGISTRY
+    /// registry segment the bar is published to, or NULL if it has no slot there
+    struct tqdm_registry *_registry;
+    /// index of the bar's slot in _registry
+    unsigned int _registry_slot;
+#endif // TQDM_REGISTRY
+#if TQDM_MEASURE_OVERHEAD
+    /// time in ns spent drawing the bar and in updates that read the clock, summed over all threads
+    uint64_t _overhead_ns;
+#endif // TQDM_MEASURE_OVERHEAD
 } tqdm;
 
 #if TQDM_DYNAMIC_RESIZE
-/// flag set when a SIGWINCH is received
+/// number of SIGWINCHs received, compared against each bar's _winch_seen
 static volatile sig_atomic_t _tqdm_winch = 0;
 
-/// signal handler for SIGWINCH to set _tqdm_winch flag
+/// signal handler for SIGWINCH to bump the _tqdm_winch counter
 static void _tqdm_handle_sigwinch(int signo) {
     (void)signo;
-    _tqdm_winch = 1;
+    _tqdm_winch = _tqdm_winch + 1;
 }
 
 /// helper function to install the SIGWINCH handler, once program-wide
 static void _tqdm_install_sigwinch(void) {
     static int installed = 0;
     if (!installed) {
-        signal(SIGWINCH, _tqdm_handle_sigwinch);
+        // SA_RESTART so that resizes don't interrupt the program's own blocking I/O
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = _tqdm_handle_sigwinch;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_RESTART;
+        sigaction(SIGWINCH, &sa, NULL);
         installed = 1;
     }
 }
@@ -140,6 +350,27 @@ static long _tqdm_now_ms() {
     return _tqdm_timespec_to_ms(&ts);
 }
 
+/// helper to start timing work done inside tqdm, returning the time to pass to _tqdm_overhead_end
+static uint64_t _tqdm_overhead_begin(void) {
+#if TQDM_MEASURE_OVERHEAD
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    return 0;
+#endif // TQDM_MEASURE_OVERHEAD
+}
+
+/// helper to add the time since _tqdm_overhead_begin to the overhead of a bar
+static void _tqdm_overhead_end(tqdm *t, uint64_t start_ns) {
+#if TQDM_MEASURE_OVERHEAD
+    __atomic_fetch_add(&t->_overhead_ns, _tqdm_overhead_begin() - start_ns, __ATOMIC_RELAXED);
+#else
+    (void)t;
+    (void)start_ns;
+#endif // TQDM_MEASURE_OVERHEAD
+}
+
 /// helper to get terminal width, defaults to TQDM_DEFAULT_TERMINAL_WIDTH if unavailable
 static unsigned int _tqdm_terminal_size(tqdm *t) {
     struct winsize w;
@@ -151,29 +382,306 @@ static unsigned int _tqdm_terminal_size(tqdm *t) {
             : TQDM_DEFAULT_TERMINAL_WIDTH;
 }
 
-/// helper to format time and write into buffer of size n
-static void _tqdm_format_time(double milliseconds, char *buffer, size_t n) {
-    int total_seconds = (int)(milliseconds / 1000 + 0.5);
-    int h = total_seconds / 3600;
-    int m = (total_seconds % 3600) / 60;
-    int s = total_seconds % 60;
+/**
+ * @brief Helper to re-tune a clock-read stride so that about half of min_interval_ms passes between reads
+ *
+ * The stride grows by at most 2x per read and never exceeds TQDM_MAXIMUM_STRIDE.
+ * A read that comes far later than planned means the rate has dropped since the
+ * stride was learned, so the new stride is shrunk by the overshoot as well, in
+ * case the rate is still falling; it grows back within a few reads if not.
+ *
+ * @return New stride, at least 1
+ */
+static uint64_t _tqdm_adapt_stride(uint64_t stride, uint64_t delta_steps, long delta_ms, uint32_t min_interval_ms) {
+    double limit = MIN((double)stride * 2, TQDM_MAXIMUM_STRIDE); // grow by at most 2x per read
+
+    if (min_interval_ms == 0) {
+        // every update redraws, so the clock must be read on every update
+        stride = 1;
+    } else if (delta_ms <= 0) {
+        // clock has not ticked since the last read, so the stride is too small
+        stride = (uint64_t)limit;
+    } else {
+        double target = (double)delta_steps * (min_interval_ms / 2) / delta_ms;
+        if (delta_ms > 2 * (long)min_interval_ms) {
+            target = target * min_interval_ms / delta_ms;
+        }
+        stride = (uint64_t)MIN(target, limit);
+    }
+    return MAX(stride, 1);
+}
+
+/**
+ * @brief Helper to schedule the next clock read
+ *
+ * Reading the clock on every update dominates the cost of tight loops, so
+ * tqdm_update only consults it once every `miniters` steps. When `miniters`
+ * is 0, the stride is re-tuned on every clock read so that roughly half of
+ * `min_interval_ms` passes between reads, in the spirit of Python tqdm's
+ * dynamic miniters.
+ */
+static void _tqdm_schedule_check(tqdm *t, uint64_t steps, long now_ms) {
+    uint64_t stride = t->miniters;
+
+    if (stride == 0) {
+        stride = _tqdm_adapt_stride(t->_miniters, steps - t->_last_check_steps,
+                                    now_ms - t->_last_check, t->min_interval_ms);
+        t->_miniters = stride;
+    }
+
+    t->_last_check = now_ms;
+    t->_last_check_steps = steps;
+
+    // never step past the total so that the final update is always drawn
+    uint64_t next = steps < t->total_steps && t->total_steps - steps > stride
+                        ? steps + stride
+                        : t->total_steps;
+    __atomic_store_n(&t->_next_check, next, __ATOMIC_RELEASE);
+}
+
+#ifdef __SIZEOF_INT128__
+/// 128-bit unsigned integer for exact intermediate products, a GCC extension in ISO C
+__extension__ typedef unsigned __int128 _tqdm_u128;
+#endif
+
+/// helper to compute floor(a * b / c) exactly, without overflowing the intermediate product
+static uint64_t _tqdm_muldiv(uint64_t a, uint64_t b, uint64_t c) {
+#ifdef __SIZEOF_INT128__
+    return (uint64_t)((_tqdm_u128)a * b / c);
+#else
+    return (uint64_t)((long double)a * b / c);
+#endif
+}
+
+/// two-digit decimal strings for 00 to 99, so that integers are formatted two digits at a time
+static const char _tqdm_digit_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/// helper to write the decimal digits of v into out, returning the number of characters written
+static size_t _tqdm_format_u64(char *out, uint64_t v) {
+    char digits[20];
+    char *p = digits + sizeof(digits);
+
+    while (v >= 100) {
+        p -= 2;
+        memcpy(p, &_tqdm_digit_pairs[(v % 100) * 2], 2);
+        v /= 100;
+    }
+    if (v >= 10) {
+        p -= 2;
+        memcpy(p, &_tqdm_digit_pairs[v * 2], 2);
+    } else {
+        *--p = (char)('0' + v);
+    }
+
+    size_t n = digits + sizeof(digits) - p;
+    memcpy(out, p, n);
+    return n;
+}
+
+/// helper to write v right-aligned in a field of at least `width` characters, padded with spaces
+static size_t _tqdm_format_u64_padded(char *out, uint64_t v, size_t width) {
+    char digits[20];
+    size_t n = _tqdm_format_u64(digits, v);
+    size_t pad = n < width ? width - n : 0;
+    memset(out, ' ', pad);
+    memcpy(out + pad, digits, n);
+    return pad + n;
+}
+
+/// helper to write v with at least two digits, as printf's "%02d" would
+static size_t _tqdm_format_2digits(char *out, uint64_t v) {
+    if (v < 100) {
+        memcpy(out, &_tqdm_digit_pairs[v * 2], 2);
+        return 2;
+    }
+    return _tqdm_format_u64(out, v);
+}
+
+/// helper to write a non-negative value rounded to two decimals, as printf's "%.2f" would
+static size_t _tqdm_format_fixed2(char *out, double v) {
+    // clamp so that the value in hundredths fits in 64 bits, and map NaN to 0
+    v = v > 0 ? MIN(v, 1e17) : 0;
+    uint64_t hundredths = (uint64_t)(v * 100 + 0.5);
+
+    size_t n = _tqdm_format_u64(out, hundredths / 100);
+    out[n++] = '.';
+    memcpy(out + n, &_tqdm_digit_pairs[(hundredths % 100) * 2], 2);
+    return n + 2;
+}
+
+/// maximum number of bytes of the unit shown after the bar
+#define TQDM_MAXIMUM_UNIT_SIZE 16
+
+/**
+ * @brief Helper to write a non-negative value with three significant digits and a unit prefix
+ *
+ * The value is divided by `divisor` until it is below 1000, then written as
+ * 1.23, 12.3 or 123 followed by the prefix for the number of divisions, as
+ * Python tqdm's unit_scale does. A divisor of 1024 uses IEC prefixes (Ki, Mi,
+ * ...), any other divisor SI prefixes (k, M, ...).
+ *
+ * @return Number of characters written, at most 8
+ */
+static size_t _tqdm_format_scaled(char *out, double v, uint32_t divisor) {
+    static const char *const si[] = { "", "k", "M", "G", "T", "P", "E", "Z", "Y" };
+    static const char *const iec[] = { "", "Ki", "Mi", "Gi", "Ti", "Pi", "Ei", "Zi", "Yi" };
+    const char *const *prefixes = divisor == 1024 ? iec : si;
+    double base = divisor > 1 ? divisor : 1000;
+
+    // map NaN and negative values to 0, and stop at the largest prefix
+    v = v > 0 ? v : 0;
+    unsigned int i = 0;
+    while (v >= 999.5 && i < 8) {
+        v /= base;
+        i++;
+    }
+    v = MIN(v, 999);
+
+    size_t n;
+    if (v < 9.995) {
+        n = _tqdm_format_fixed2(out, v);
+    } else if (v < 99.95) {
+        uint64_t tenths = (uint64_t)(v * 10 + 0.5);
+        n = _tqdm_format_u64(out, tenths / 10);
+        out[n++] = '.';
+        out[n++] = (char)('0' + tenths % 10);
+    } else {
+        n = _tqdm_format_u64(out, (uint64_t)(v + 0.5));
+    }
+
+    size_t prefix_length = strlen(prefixes[i]);
+    memcpy(out + n, prefixes[i], prefix_length);
+    return n + prefix_length;
+}
+
+/// helper to format a duration as MM:SS, or HH:MM:SS if hours are present, returning its length
+static size_t _tqdm_format_time(char *out, double milliseconds) {
+    // clamp to 10^15 ms (over 30,000 years), which keeps the result short
+    uint64_t ms = milliseconds > 0 ? (uint64_t)MIN(milliseconds, 1e15) : 0;
+    uint64_t total_seconds = (ms + 500) / 1000;
+    uint64_t h = total_seconds / 3600;
+    uint64_t m = (total_seconds % 3600) / 60;
+    uint64_t s = total_seconds % 60;
+    size_t n = 0;
 
     // print hours if present
     if (h > 0) {
-        snprintf(buffer, n, "%02d:%02d:%02d", h, m, s);
+        n += _tqdm_format_2digits(out, h);
+        out[n++] = ':';
+    }
+    n += _tqdm_format_2digits(out + n, m);
+    out[n++] = ':';
+    n += _tqdm_format_2digits(out + n, s);
+    return n;
+}
+
+/* ==================== ETA models ==================== */
+
+/// sample function of models that need no samples
+static void _tqdm_eta_ignore_sample(tqdm *t, uint64_t steps, long now_ms) {
+    (void)t;
+    (void)steps;
+    (void)now_ms;
+}
+
+/// rate function of the total-average model: steps over the whole run divided by its duration
+static double _tqdm_eta_average_rate(const tqdm *t, uint64_t steps, long now_ms) {
+    long elapsed = now_ms - t->_start;
+    return elapsed > 0 ? steps / (double)elapsed : -1;
+}
+
+/**
+ * @brief Helper to fold the progress made since the previous sample into the smoothed rate
+ *
+ * As in Python tqdm, the steps and the time between redraws are averaged
+ * separately, each with weight `smoothing` given to the latest sample, and
+ * the rate is the ratio of the two averages. Both averages start from zero,
+ * but their bias cancels out in the ratio, so the first sample is exact.
+ */
+static void _tqdm_eta_ema_sample(tqdm *t, uint64_t steps, long now_ms) {
+    double alpha = t->smoothing;
+    t->_ema_steps = alpha * (double)(steps - t->_rate_steps) + (1 - alpha) * t->_ema_steps;
+    t->_ema_ms = alpha * (now_ms - t->_rate_time) + (1 - alpha) * t->_ema_ms;
+}
+
+/// rate function of the EMA model, which falls back to the total average with no smoothing
+static double _tqdm_eta_ema_rate(const tqdm *t, uint64_t steps, long now_ms) {
+    if (t->smoothing > 0 && t->_ema_ms > 0) {
+        return t->_ema_steps / t->_ema_ms;
+    }
+    return _tqdm_eta_average_rate(t, steps, now_ms);
+}
+
+/// helper to append a sample to the window, replacing the oldest one once it is full
+static void _tqdm_eta_window_sample(tqdm *t, uint64_t steps, long now_ms) {
+    unsigned int i;
+    if (t->_window_len < TQDM_ETA_WINDOW) {
+        i = (t->_window_head + t->_window_len++) % TQDM_ETA_WINDOW;
     } else {
-        snprintf(buffer, n, "%02d:%02d", m, s);
+        i = t->_window_head;
+        t->_window_head = (i + 1) % TQDM_ETA_WINDOW;
+    }
+    t->_window_ms[i] = now_ms;
+    t->_window_steps[i] = steps;
+}
+
+/**
+ * @brief Helper to compute the rate of the windowed model
+ *
+ * Fits a least-squares line of steps against time through the samples in the
+ * window and returns its slope, so that the rate only reflects the last
+ * TQDM_ETA_WINDOW redraws and follows a rate that keeps drifting. Offsets from
+ * the oldest sample are used to keep the sums precise. Falls back to the total
+ * average until the window holds two samples at different times.
+ */
+static double _tqdm_eta_window_rate(const tqdm *t, uint64_t steps, long now_ms) {
+    unsigned int n = t->_window_len;
+    unsigned int head = t->_window_head;
+    long ms0 = t->_window_ms[head];
+    uint64_t steps0 = t->_window_steps[head];
+
+    double sum_x = 0, sum_y = 0;
+    for (unsigned int k = 0; k < n; k++) {
+        unsigned int i = (head + k) % TQDM_ETA_WINDOW;
+        sum_x += t->_window_ms[i] - ms0;
+        sum_y += (double)(t->_window_steps[i] - steps0);
+    }
+    double mean_x = n ? sum_x / n : 0;
+    double mean_y = n ? sum_y / n : 0;
+
+    double sxy = 0, sxx = 0;
+    for (unsigned int k = 0; k < n; k++) {
+        unsigned int i = (head + k) % TQDM_ETA_WINDOW;
+        double dx = t->_window_ms[i] - ms0 - mean_x;
+        sxy += dx * ((double)(t->_window_steps[i] - steps0) - mean_y);
+        sxx += dx * dx;
+    }
+    if (sxx <= 0) {
+        return _tqdm_eta_average_rate(t, steps, now_ms);
     }
+    return MAX(sxy / sxx, 0);
 }
 
+/// model estimating the rate as the average over the whole run
+static const tqdm_eta_model tqdm_eta_average = { _tqdm_eta_ignore_sample, _tqdm_eta_average_rate };
+/// model estimating the rate with exponential moving averages weighted by the bar's `smoothing`
+static const tqdm_eta_model tqdm_eta_ema = { _tqdm_eta_ema_sample, _tqdm_eta_ema_rate };
+/// model estimating the rate by linear regression over the last TQDM_ETA_WINDOW redraws
+static const tqdm_eta_model tqdm_eta_window = { _tqdm_eta_window_sample, _tqdm_eta_window_rate };
+
 /**
  * @brief Initialise a tqdm progress bar
  *
  * @param t Pointer to tqdm struct to initialise
- * @param total_steps Total number of steps
+ * @param total_steps Total number of steps, or TQDM_UNKNOWN_TOTAL if not known
  * @param description Description string to display alongside the progress bar
  */
-static void tqdm_init(tqdm *t, uint64_t total_steps, const char *description, uint32_t min_interval_ms) {
+static inline void tqdm_init(tqdm *t, uint64_t total_steps, const char *description, uint32_t min_interval_ms) {
     t->total_steps = total_steps;
     t->current_steps = 0;
     t->description = description ? description : "";
@@ -183,192 +691,2391 @@ static void tqdm_init(tqdm *t, uint64_t total_steps, const char *description, ui
         t->_after_description = "";
     }
     t->min_interval_ms = min_interval_ms;
+    t->miniters = 0;
+    t->eta_model = &tqdm_eta_ema;
+    t->smoothing = 0.3f;
+    t->eta_state = NULL;
+    t->unit = "it";
+    t->unit_scale = false;
+    t->unit_divisor = 1000;
+    t->leave = true;
+    t->json_fd = -1;
+    t->json_interval_ms = 1000;
     t->_start = _tqdm_now_ms();
     t->_last_print = t->_start;
+    t->_last_check = t->_start;
+    t->_json_last = t->_start;
+    t->_last_check_steps = 0;
+    t->_next_check = 0;
+    t->_miniters = 1;
+    t->_rate_steps = 0;
+    t->_rate_time = t->_start;
+    t->_ema_steps = 0;
+    t->_ema_ms = 0;
+    // the window starts with the start of the run, so that the first redraw can be fitted
+    t->_window_ms[0] = t->_start;
+    t->_window_steps[0] = 0;
+    t->_window_head = 0;
+    t->_window_len = 1;
+    t->_stats_seq = 0;
+    t->_stats_steps = 0;
+    t->_stats_ms = t->_start;
+    t->_stats_rate = -1;
     t->_drawn = false;
     t->_done = false;
+    t->_closed = false;
+    t->_disabled = false;
+    t->_lock = 0;
     t->_fd = STDERR_FILENO;
     t->_term_width = _tqdm_terminal_size(t);
+    t->_last_width = 0;
+    t->_last_line_len = 0;
+    t->_manager = NULL;
+    t->_parent = NULL;
 
 #if TQDM_DYNAMIC_RESIZE
+    // query the width again on the first draw, in case _fd is changed after initialisation
+    t->_winch_seen = _tqdm_winch - 1;
     _tqdm_install_sigwinch();
 #endif // TQDM_DYNAMIC_RESIZE
+#if TQDM_REGISTRY
+    t->_registry = NULL;
+    t->_registry_slot = 0;
+#endif // TQDM_REGISTRY
+#if TQDM_MEASURE_OVERHEAD
+    t->_overhead_ns = 0;
+#endif // TQDM_MEASURE_OVERHEAD
+}
+
+/// helper to feed the bar's ETA model a sample, skipping redraws at which no time has passed
+static void _tqdm_sample_rate(tqdm *t, uint64_t steps, long now_ms) {
+    if (now_ms - t->_rate_time <= 0) {
+        return;
+    }
+    t->eta_model->sample(t, steps, now_ms);
+    t->_rate_steps = steps;
+    t->_rate_time = now_ms;
+
+    // publish the sample and the new estimate together for tqdm_snapshot under the seqlock
+    double rate = t->eta_model->rate(t, steps, now_ms);
+    uint32_t seq = t->_stats_seq;
+    __atomic_store_n(&t->_stats_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&t->_stats_steps, steps, __ATOMIC_RELAXED);
+    __atomic_store_n(&t->_stats_ms, now_ms, __ATOMIC_RELAXED);
+    __atomic_store(&t->_stats_rate, &rate, __ATOMIC_RELAXED);
+    __atomic_store_n(&t->_stats_seq, seq + 2, __ATOMIC_RELEASE);
 }
 
 /**
- * @brief Update the tqdm progress bar by a given number of steps
+ * @brief Helper to render the progress bar line for a given step count into a buffer
  *
- * @param t Pointer to tqdm struct to update
- * @param step Number of steps to increment
+ * The text after the bar is formatted first, as its width determines the
+ * bar's. The bar itself is then emitted straight into the output with at most
+ * three copies: a run of full blocks, one partial block and a run of spaces,
+ * all taken from precomputed runs. The description is truncated if needed so
+ * that the line always fits in TQDM_MAXIMUM_LINE_SIZE bytes.
+ *
+ * @return Length of the line written to out, which is not null-terminated
  */
-static void tqdm_update(tqdm *t, uint64_t step) {
-    long now_ms = _tqdm_now_ms();
-    long last_ms = t->_last_print;
+static size_t _tqdm_render(const tqdm *t, uint64_t steps, long now_ms, unsigned int width, char *out) {
+    double elapsed = now_ms - t->_start;
+    // with an unknown total, only the count, elapsed time and rate are shown
+    bool unknown = t->total_steps == TQDM_UNKNOWN_TOTAL;
+    // exact integer geometry: progress is counted in 1/200ths for the rounded percentage
+    // and in eighths of a cell for the bar, clamped to 100% once the total is reached
+    bool complete = !unknown && steps >= t->total_steps;
+    uint64_t half_percent = complete || unknown ? 200 : _tqdm_muldiv(steps, 200, t->total_steps);
 
-    t->current_steps += step;
+    // steps per ms, as estimated by the bar's ETA model; negative while unknown
+    double iter_per_ms = t->eta_model->rate(t, steps, now_ms);
 
-    // if progress bar is done, do nothing
-    if (t->_done) {
-        return;
+    // format the text after the bar without snprintf: it is locale-independent and much cheaper
+    char after_bar[160];
+    size_t after_bar_length = 0;
+    size_t unit_length = strnlen(t->unit, TQDM_MAXIMUM_UNIT_SIZE);
+    if (!unknown) {
+        memcpy(after_bar, "| ", 2);
+        after_bar_length += 2;
     }
-
-    bool force_redraw = false;
-
-#if TQDM_DYNAMIC_RESIZE
-    if (TQDM_DYNAMIC_RESIZE && _tqdm_winch) {
-        _tqdm_winch = 0; // reset flag
-        force_redraw = true;
+    if (t->unit_scale) {
+        after_bar_length += _tqdm_format_scaled(after_bar + after_bar_length, (double)steps, t->unit_divisor);
+    } else {
+        after_bar_length += _tqdm_format_u64(after_bar + after_bar_length, steps);
     }
-#endif // TQDM_DYNAMIC_RESIZE
+    if (unknown) {
+        memcpy(after_bar + after_bar_length, t->unit, unit_length);
+        after_bar_length += unit_length;
+    } else if (t->unit_scale) {
+        after_bar[after_bar_length++] = '/';
+        after_bar_length += _tqdm_format_scaled(after_bar + after_bar_length, (double)t->total_steps,
+                                                t->unit_divisor);
+    } else {
+        after_bar[after_bar_length++] = '/';
+        after_bar_length += _tqdm_format_u64(after_bar + after_bar_length, t->total_steps);
+    }
+    memcpy(after_bar + after_bar_length, " [", 2);
+    after_bar_length += 2;
+    after_bar_length += _tqdm_format_time(after_bar + after_bar_length, elapsed);
+    // estimate the remaining time from the rate, shown as '?' while the rate is unknown or zero
+    if (unknown) {
+        // nothing to estimate
+    } else if (complete) {
+        after_bar[after_bar_length++] = '<';
+        after_bar_length += _tqdm_format_time(after_bar + after_bar_length, 0);
+    } else if (iter_per_ms > 0) {
+        after_bar[after_bar_length++] = '<';
+        after_bar_length += _tqdm_format_time(after_bar + after_bar_length,
+                                              (t->total_steps - steps) / iter_per_ms);
+    } else {
+        memcpy(after_bar + after_bar_length, "<?", 2);
+        after_bar_length += 2;
+    }
+    memcpy(after_bar + after_bar_length, ", ", 2);
+    after_bar_length += 2;
+    // rate in units per second
+    if (iter_per_ms < 0) {
+        after_bar[after_bar_length++] = '?';
+    } else if (t->unit_scale) {
+        after_bar_length += _tqdm_format_scaled(after_bar + after_bar_length, iter_per_ms * 1000.0,
+                                                t->unit_divisor);
+    } else {
+        after_bar_length += _tqdm_format_fixed2(after_bar + after_bar_length, iter_per_ms * 1000.0);
+    }
+    memcpy(after_bar + after_bar_length, t->unit, unit_length);
+    after_bar_length += unit_length;
+    memcpy(after_bar + after_bar_length, "/s", 2);
+    after_bar_length += 2;
+#if TQDM_MEASURE_OVERHEAD
+    // share of the elapsed time spent inside tqdm, in percent
+    memcpy(after_bar + after_bar_length, ", tqdm ", 7);
+    after_bar_length += 7;
+    uint64_t overhead_ns = __atomic_load_n(&t->_overhead_ns, __ATOMIC_RELAXED);
+    after_bar_length += _tqdm_format_fixed2(after_bar + after_bar_length,
+                                            elapsed > 0 ? overhead_ns / (elapsed * 1e4) : 0);
+    after_bar[after_bar_length++] = '%';
+#endif // TQDM_MEASURE_OVERHEAD
+    after_bar[after_bar_length++] = ']';
 
-    // if minimum interval not reached, skip update
-    if (t->_drawn &&        // only skip if already drawn
-        !force_redraw &&    // but don't skip if terminal resized in dynamic mode
-        now_ms - last_ms < t->min_interval_ms &&
-        t->current_steps < t->total_steps) {
-        return;
+    // description and percentage before the bar
+    size_t pos = strnlen(t->description, TQDM_MAXIMUM_TERMINAL_WIDTH);
+    memcpy(out, t->description, pos);
+    size_t after_description_length = strlen(t->_after_description);
+    memcpy(out + pos, t->_after_description, after_description_length);
+    pos += after_description_length;
+    if (unknown) {
+        memcpy(out + pos, after_bar, after_bar_length);
+        return pos + after_bar_length;
     }
+    pos += _tqdm_format_u64_padded(out + pos, (half_percent + 1) / 2, 3);
+    memcpy(out + pos, "% |", 3);
+    pos += 3;
 
-    double elapsed = now_ms - t->_start;
-    double iter_per_ms = t->current_steps / (elapsed + 1e-9);
-    double percent_complete = (double)t->current_steps / t->total_steps;
-    unsigned int width = TQDM_DYNAMIC_RESIZE ? _tqdm_terminal_size(t) : t->_term_width;
-
-    // compute an estimate of the remaining time based on current steps per ms
-    double remaining = (iter_per_ms > 0 && t->current_steps < t->total_steps)
-                        ? (t->total_steps - t->current_steps) / iter_per_ms
-                        : 0;
-
-    // format elapsed and remaining time strings
-    char elapsed_str[32], remaining_str[32];
-    _tqdm_format_time(elapsed, elapsed_str, sizeof(elapsed_str));
-    _tqdm_format_time(remaining, remaining_str, sizeof(remaining_str));
-
-    // build the bar using utf-8 block characters
-    char bar[1024];
-    int bar_pos = 0;
-
-    const char *orient = t->_drawn ? "\r\033[K" : "";
-    bar_pos = snprintf(bar, sizeof(bar), "%s", orient);
-
-    int before_bar_length = snprintf(
-        bar + bar_pos, sizeof(bar) - bar_pos,
-        "%s%s%3.0f%% |",
-        t->description,
-        t->_after_description,
-        percent_complete * 100
-    );
-    bar_pos += before_bar_length;
-
-    char after_bar[128];
-    int after_bar_length = snprintf(
-        after_bar, sizeof(after_bar),
-        "| %llu/%llu [%s<%s, %.2fit/s]",
-        t->current_steps, t->total_steps,
-        elapsed_str,
-        remaining_str,
-        iter_per_ms * 1000.0 // convert to steps/s
-    );
-
-    // compute length of non-bar elements, accounting for nonprintable characters
-    unsigned int nonbar_width = before_bar_length + after_bar_length;
+    // compute length of non-bar elements
+    unsigned int nonbar_width = pos + after_bar_length;
     unsigned int bar_width = MAX((int)(width - nonbar_width), TQDM_MINIMUM_BAR_WIDTH);
 
     // compute the number of full and partial blocks to display
-    double filled_cells = percent_complete * bar_width;
-    int full_cells = (int)filled_cells;
-    double fractional_cell = filled_cells - full_cells;
-
-    // fill in the bar string
-    for (int i = 0; i < bar_width; i++) {
-        ssize_t idx = TQDM_EMPTY_IDX;
-        if (i < full_cells) {
-            idx = TQDM_FULL_IDX;
-        } else if (i == full_cells) {
-            // if last partial block, determine which block to use
-            idx = (ssize_t)(fractional_cell * 8);
-        }
+    uint64_t filled_eighths = complete ? (uint64_t)bar_width * 8
+                                       : _tqdm_muldiv(steps, (uint64_t)bar_width * 8, t->total_steps);
+    unsigned int full_cells = (unsigned int)(filled_eighths / 8);
+    unsigned int partial_idx = (unsigned int)(filled_eighths % 8);
+    unsigned int empty_cells = bar_width - full_cells;
 
-        const char *block = TQDM_BLOCKS[idx];
-        memcpy(bar + bar_pos, block, strlen(block));
-        bar_pos += strlen(block);
+    memcpy(out + pos, _tqdm_full_run, full_cells * TQDM_BLOCK_BYTES);
+    pos += full_cells * TQDM_BLOCK_BYTES;
+    if (partial_idx != TQDM_EMPTY_IDX && empty_cells > 0) {
+        // the partial block takes the place of the first empty cell
+        memcpy(out + pos, TQDM_BLOCKS[partial_idx], TQDM_BLOCK_BYTES);
+        pos += TQDM_BLOCK_BYTES;
+        empty_cells--;
     }
+    memcpy(out + pos, _tqdm_space_run, empty_cells);
+    pos += empty_cells;
 
-    bar[bar_pos] = 0;
+    memcpy(out + pos, after_bar, after_bar_length);
+    return pos + after_bar_length;
+}
 
-    // finally, construct the complete line and write to stderr
-    char line[TQDM_MAXIMUM_TERMINAL_WIDTH];
-    int written = snprintf(line, sizeof(line), "%s%s", bar, after_bar);
+#if TQDM_REGISTRY
+/* ==================== registry ==================== */
 
-    if (written >= 0) {
-        write(t->_fd, line, written);
-    } else {
-        fprintf(stderr, "tqdm: hmmm, there was an error formatting the progress bar\n");
-    }
+/// number of bars a process can publish at once
+#ifndef TQDM_REGISTRY_SLOTS
+#define TQDM_REGISTRY_SLOTS 64
+#endif
 
-    // update last print time to now
-    t->_last_print = now_ms;
-    t->_drawn = true;
-    if (t->current_steps >= t->total_steps) {
-        t->_done = true;
-        write(t->_fd, "\n", 1);
-    }
-}
+/// size of the description buffer in a registry slot, including the terminating null
+#define TQDM_REGISTRY_DESCRIPTION_SIZE 64
 
-/* ==================== convenience macros ==================== */
+/// value identifying a registry segment and its layout
+#define TQDM_REGISTRY_MAGIC 0x7164716dU
+
+/// directory holding the registry segments, one per process, named tqdm.<pid>
+#define TQDM_REGISTRY_DIR "/dev/shm"
 
 /**
- * @brief Pair of macros to create a for loop with an integrated tqdm progress bar
- *
- * @param var Loop variable
- * @param start Starting value (inclusive)
- * @param end Ending value (exclusive)
- * @param desc Description string for progress bar
+ * @brief Struct representing the published state of one progress bar
  *
- * Usage:
- * ```
- * int i;
- * TQDM_FOR_BEGIN(i, 0, 10000, "Processing")
- *     // loop body
- * TQDM_FOR_END;
- * ```
+ * Each slot is written by a single thread at a time under a seqlock: `seq` is
+ * odd while a write is in progress, so readers never block the publisher and
+ * retry if `seq` changed while they were copying the slot.
  */
-#define TQDM_FOR_BEGIN(var, start, end, desc)                       \
-    do {                                                            \
-        tqdm _tqdm;                                                 \
-        tqdm_init(&_tqdm, (end) - (start), (desc), 50);             \
-        for (uint64_t var = (start); var < (end); ++var) {
+typedef struct {
+    /// sequence number, odd while the slot is being written
+    uint32_t seq;
+    /// whether the slot holds a bar
+    uint32_t in_use;
+    /// total number of steps, or TQDM_UNKNOWN_TOTAL
+    uint64_t total_steps;
+    /// current step count
+    uint64_t current_steps;
+    /// time in ms when the bar was started, based on CLOCK_MONOTONIC
+    int64_t start_ms;
+    /// time in ms when the slot was last written, based on CLOCK_MONOTONIC
+    int64_t update_ms;
+    /// description, truncated and null-terminated
+    char description[TQDM_REGISTRY_DESCRIPTION_SIZE];
+} tqdm_registry_slot;
 
-#define TQDM_FOR_END                                                \
-            tqdm_update(&_tqdm, 1);                                 \
-        }                                                           \
-    } while (0)
+/// struct representing the registry segment of one process
+typedef struct tqdm_registry {
+    /// TQDM_REGISTRY_MAGIC once the segment is initialised
+    uint32_t magic;
+    /// number of slots in the segment
+    uint32_t num_slots;
+    /// process publishing to the segment
+    int64_t pid;
+    /// published bars
+    tqdm_registry_slot slots[TQDM_REGISTRY_SLOTS];
+} tqdm_registry;
+
+/// registry segment of this process, or NULL if it is not created yet
+static tqdm_registry *_tqdm_registry = NULL;
+/// process that created _tqdm_registry, as forked children must create their own
+static pid_t _tqdm_registry_pid = 0;
+/// guard for creating the segment: 0 if not created, 1 while being created, 2 once attempted
+static int _tqdm_registry_state = 0;
+
+/// helper to write the path of a process's registry segment, returning its length
+static size_t _tqdm_registry_path(char *out, pid_t pid) {
+    size_t n = sizeof(TQDM_REGISTRY_DIR "/tqdm.") - 1;
+    memcpy(out, TQDM_REGISTRY_DIR "/tqdm.", n);
+    n += _tqdm_format_u64(out + n, (uint64_t)pid);
+    out[n] = '\0';
+    return n;
+}
+
+/// helper to remove this process's registry segment at exit
+static void _tqdm_registry_unlink(void) {
+    if (_tqdm_registry_pid == getpid()) {
+        char path[64];
+        _tqdm_registry_path(path, _tqdm_registry_pid);
+        unlink(path);
+    }
+}
 
 /**
- * @brief Pair of macros to iterate over a range[0, n) with an integrated tqdm progress bar
+ * @brief Helper to get this process's registry segment, creating it on first use
  *
- * @param n Number of iterations
+ * The segment is created as TQDM_REGISTRY_DIR/tqdm.<pid> and removed at exit.
+ * A forked child starts afresh with its own segment. Returns NULL if the
+ * segment could not be created, or while another thread is creating it.
+ */
+static tqdm_registry *_tqdm_registry_get(void) {
+    pid_t pid = getpid();
+    if (__atomic_load_n(&_tqdm_registry_pid, __ATOMIC_ACQUIRE) == pid) {
+        return _tqdm_registry;
+    }
+
+    int state = __atomic_load_n(&_tqdm_registry_state, __ATOMIC_RELAXED);
+    if (state == 2) {
+        // created by the parent of this forked process, so start again
+        state = 0;
+        __atomic_store_n(&_tqdm_registry_state, 0, __ATOMIC_RELAXED);
+    }
+    if (!__atomic_compare_exchange_n(&_tqdm_registry_state, &state, 1, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+
+    char path[64];
+    _tqdm_registry_path(path, pid);
+    tqdm_registry *r = NULL;
+    // the name is predictable and the directory world-writable, so only ever map a fresh file
+    // of our own: a segment left by an earlier process with this pid is removed first, and
+    // anything else another user put there makes the process go unpublished
+    unlink(path);
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0644);
+    if (fd >= 0) {
+        void *p = ftruncate(fd, sizeof(tqdm_registry)) == 0
+                    ? mmap(NULL, sizeof(tqdm_registry), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                    : MAP_FAILED;
+        close(fd);
+        if (p != MAP_FAILED) {
+            r = (tqdm_registry *)p;
+            r->num_slots = TQDM_REGISTRY_SLOTS;
+            r->pid = pid;
+            __atomic_store_n(&r->magic, TQDM_REGISTRY_MAGIC, __ATOMIC_RELEASE);
+        } else {
+            unlink(path);
+        }
+    }
+
+    // a parent's segment stays mapped in a forked child, but is no longer written to
+    _tqdm_registry = r;
+    static bool cleanup_registered = false;
+    if (r && !cleanup_registered) {
+        atexit(_tqdm_registry_unlink);
+        cleanup_registered = true;
+    }
+    __atomic_store_n(&_tqdm_registry_pid, pid, __ATOMIC_RELEASE);
+    __atomic_store_n(&_tqdm_registry_state, 2, __ATOMIC_RELEASE);
+    return r;
+}
+
+/// helper to publish the state of a bar to its registry slot, claiming one if needed
+static void _tqdm_registry_publish(tqdm *t, uint64_t steps, long now_ms) {
+    tqdm_registry *r = _tqdm_registry_get();
+    if (r == NULL) {
+        return;
+    }
+
+    if (t->_registry != r) {
+        // claim a free slot; a bar without one is simply not published
+        unsigned int i = 0;
+        for (; i < TQDM_REGISTRY_SLOTS; i++) {
+            uint32_t free_slot = 0;
+            if (__atomic_compare_exchange_n(&r->slots[i].in_use, &free_slot, 1, false,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+        if (i == TQDM_REGISTRY_SLOTS) {
+            return;
+        }
+        t->_registry = r;
+        t->_registry_slot = i;
+    }
+
+    tqdm_registry_slot *slot = &r->slots[t->_registry_slot];
+    uint32_t seq = slot->seq;
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store_n(&slot->total_steps, t->total_steps, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->current_steps, steps, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->start_ms, (int64_t)t->_start, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->update_ms, (int64_t)now_ms, __ATOMIC_RELAXED);
+    size_t n = strnlen(t->description, TQDM_REGISTRY_DESCRIPTION_SIZE - 1);
+    memcpy(slot->description, t->description, n);
+    slot->description[n] = '\0';
+
+    __atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/// helper to give up the registry slot of a bar that is done
+static void _tqdm_registry_release(tqdm *t) {
+    if (t->_registry != NULL && t->_registry == _tqdm_registry) {
+        __atomic_store_n(&t->_registry->slots[t->_registry_slot].in_use, 0, __ATOMIC_RELEASE);
+    }
+    t->_registry = NULL;
+}
+
+/**
+ * @brief Read a consistent copy of a registry slot, without blocking its publisher
  *
- * Usage:
- * ```
- * TQDM_TRANGE(10000)
- *     // loop body
- * TQDM_END_TRANGE;
- * ```
+ * @param slot Pointer to the slot to read, usually in another process's segment
+ * @param out Pointer to the copy to fill in
+ * @return true if the slot holds a bar, false if it is free
  */
-#define TQDM_TRANGE(n)                                              \
-    do {                                                            \
-        tqdm _tqdm;                                                 \
-        tqdm_init(&_tqdm, (n), "Processing", 50);                   \
-        for (uint64_t _tqdm_i = 0; _tqdm_i < (n); ++_tqdm_i) {
+static inline bool tqdm_registry_read(const tqdm_registry_slot *slot, tqdm_registry_slot *out) {
+    for (;;) {
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            sched_yield();
+            continue;
+        }
+        out->in_use = __atomic_load_n(&slot->in_use, __ATOMIC_RELAXED);
+        out->total_steps = __atomic_load_n(&slot->total_steps, __ATOMIC_RELAXED);
+        out->current_steps = __atomic_load_n(&slot->current_steps, __ATOMIC_RELAXED);
+        out->start_ms = __atomic_load_n(&slot->start_ms, __ATOMIC_RELAXED);
+        out->update_ms = __atomic_load_n(&slot->update_ms, __ATOMIC_RELAXED);
+        memcpy(out->description, (const char *)slot->description, TQDM_REGISTRY_DESCRIPTION_SIZE);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq) {
+            out->seq = seq;
+            out->description[TQDM_REGISTRY_DESCRIPTION_SIZE - 1] = '\0';
+            return out->in_use && seq != 0;
+        }
+    }
+}
+#endif // TQDM_REGISTRY
 
-#define TQDM_END_TRANGE                                             \
-            tqdm_update(&_tqdm, 1);                                 \
-        }                                                           \
-    } while (0)
+static void _tqdm_manager_draw(struct tqdm_manager *m, tqdm *t, uint64_t steps, bool done, long now_ms);
+static void _tqdm_manager_lock(struct tqdm_manager *m);
+static void _tqdm_manager_unlock(struct tqdm_manager *m);
+static inline void tqdm_update_concurrent(tqdm *t, uint64_t step);
 
-#ifdef __cplusplus
+/// helper to mark a bar as done and park its update fast path, returning false if it already was
+static bool _tqdm_mark_done(tqdm *t) {
+    __atomic_store_n(&t->_next_check, UINT64_MAX, __ATOMIC_RELAXED);
+    __atomic_store_n(&t->_done, true, __ATOMIC_RELAXED);
+    // a parked bar is done but not yet closed, so closing it still counts as the first time
+    bool first = !__atomic_exchange_n(&t->_closed, true, __ATOMIC_RELAXED);
+#if TQDM_REGISTRY
+    if (first) {
+        _tqdm_registry_release(t);
+    }
+#endif // TQDM_REGISTRY
+    return first;
 }
-#endif // __cplusplus
+
+/// helper to stop drawing a bar whose output is not a terminal
+static void _tqdm_disable(tqdm *t) {
+    t->_disabled = true;
+#if !TQDM_REGISTRY
+    // nobody sees the bar, so park it on the update fast path, unless it writes JSON lines;
+    // a child is only parked until its total, so that its completion still advances its parent
+    if (t->json_fd < 0 && t->_parent) {
+        __atomic_store_n(&t->_next_check, t->total_steps, __ATOMIC_RELAXED);
+    } else if (t->json_fd < 0) {
+        __atomic_store_n(&t->_done, true, __ATOMIC_RELAXED);
+        __atomic_store_n(&t->_next_check, UINT64_MAX, __ATOMIC_RELAXED);
+    }
+#endif // !TQDM_REGISTRY
+}
+
+/// helper to advance the parent of a bar that has just completed
+static void _tqdm_roll_up(tqdm *t) {
+    if (t->_parent) {
+        // children may complete on different threads
+        tqdm_update_concurrent(t->_parent, 1);
+    }
+}
+
+/// maximum length of a JSON-lines record: the escaped description and the numeric fields
+#define TQDM_MAXIMUM_JSON_SIZE (TQDM_MAXIMUM_TERMINAL_WIDTH * 6 + 256)
+
+/// helper to write a string as the contents of a JSON string, escaped, returning its length
+static size_t _tqdm_format_json_string(char *out, const char *s, size_t n) {
+    static const char hex[] = "0123456789abcdef";
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '"' || c == '\\') {
+            out[len++] = '\\';
+            out[len++] = (char)c;
+        } else if (c < 0x20) {
+            memcpy(out + len, "\\u00", 4);
+            out[len + 4] = hex[c >> 4];
+            out[len + 5] = hex[c & 0xF];
+            len += 6;
+        } else {
+            out[len++] = (char)c;
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief Helper to write a JSON-lines progress record for a bar to its json_fd
+ *
+ * Each record is one compact JSON object on its own line, written with a
+ * single call:
+ * {"description":"...","steps":N,"total":N,"elapsed":S,"rate":R,"eta":S,"done":B}
+ * Times are in seconds and the rate in steps per second. The total is null if
+ * unknown, and the rate and eta are null until they can be estimated.
+ */
+static void _tqdm_json_write(tqdm *t, uint64_t steps, long now_ms, bool done) {
+    char record[TQDM_MAXIMUM_JSON_SIZE];
+    bool unknown = t->total_steps == TQDM_UNKNOWN_TOTAL;
+    // a managed bar is also sampled by whichever thread redraws its manager's block
+    if (t->_manager) {
+        _tqdm_manager_lock(t->_manager);
+    }
+    _tqdm_sample_rate(t, steps, now_ms);
+    double iter_per_ms = t->eta_model->rate(t, steps, now_ms);
+    if (t->_manager) {
+        _tqdm_manager_unlock(t->_manager);
+    }
+
+    size_t n = 0;
+    memcpy(record, "{\"description\":\"", 16);
+    n += 16;
+    n += _tqdm_format_json_string(record + n, t->description,
+                                  strnlen(t->description, TQDM_MAXIMUM_TERMINAL_WIDTH));
+    memcpy(record + n, "\",\"steps\":", 10);
+    n += 10;
+    n += _tqdm_format_u64(record + n, steps);
+    memcpy(record + n, ",\"total\":", 9);
+    n += 9;
+    if (unknown) {
+        memcpy(record + n, "null", 4);
+        n += 4;
+    } else {
+        n += _tqdm_format_u64(record + n, t->total_steps);
+    }
+    memcpy(record + n, ",\"elapsed\":", 11);
+    n += 11;
+    n += _tqdm_format_fixed2(record + n, (now_ms - t->_start) / 1e3);
+    memcpy(record + n, ",\"rate\":", 8);
+    n += 8;
+    if (iter_per_ms >= 0) {
+        n += _tqdm_format_fixed2(record + n, iter_per_ms * 1e3);
+    } else {
+        memcpy(record + n, "null", 4);
+        n += 4;
+    }
+    memcpy(record + n, ",\"eta\":", 7);
+    n += 7;
+    if (!unknown && steps >= t->total_steps) {
+        memcpy(record + n, "0.00", 4);
+        n += 4;
+    } else if (!unknown && iter_per_ms > 0) {
+        n += _tqdm_format_fixed2(record + n, (t->total_steps - steps) / iter_per_ms / 1e3);
+    } else {
+        memcpy(record + n, "null", 4);
+        n += 4;
+    }
+    if (done) {
+        memcpy(record + n, ",\"done\":true}\n", 14);
+        n += 14;
+    } else {
+        memcpy(record + n, ",\"done\":false}\n", 15);
+        n += 15;
+    }
+
+    write(t->json_fd, record, n);
+    t->_json_last = now_ms;
+}
+
+/**
+ * @brief Helper to draw the progress bar for a given step count
+ *
+ * Renders the whole frame, including cursor movement and the final newline,
+ * into one buffer so that it is written with a single call. The line is
+ * compared against the previously emitted one, and nothing is written if it
+ * is unchanged. With TQDM_PARTIAL_REDRAW, only the part from the first changed
+ * character onwards is written, after moving the cursor past the unchanged
+ * part.
+ *
+ * Marks the bar as drawn and, once the total is reached, as done. Fields read
+ * by concurrent updaters are stored atomically so that tqdm_update_concurrent
+ * can observe them without taking the render lock.
+ */
+static void _tqdm_draw(tqdm *t, uint64_t steps, long now_ms) {
+#if TQDM_REGISTRY
+    _tqdm_registry_publish(t, steps, now_ms);
+#endif // TQDM_REGISTRY
+    if (t->json_fd >= 0 &&
+        (steps >= t->total_steps || now_ms - t->_json_last >= (long)t->json_interval_ms)) {
+        _tqdm_json_write(t, steps, now_ms, steps >= t->total_steps);
+    }
+
+    // managed bars are drawn as part of their manager's block
+    if (t->_manager) {
+        _tqdm_manager_draw(t->_manager, t, steps, steps >= t->total_steps, now_ms);
+        return;
+    }
+
+    bool done = steps >= t->total_steps;
+    // a child without a manager would share its parent's line; checked on the first draw
+    // rather than in tqdm_init_child so that fields set afterwards, such as json_fd, apply
+    if (!t->_drawn && !t->_disabled && t->_parent) {
+        _tqdm_disable(t);
+    }
+#if TQDM_AUTO_DISABLE
+    // nobody sees a bar that isn't written to a terminal; checked on the first draw
+    // rather than at initialisation in case _fd is changed in between
+    if (!t->_drawn && !t->_disabled && !isatty(t->_fd)) {
+        _tqdm_disable(t);
+    }
+#endif // TQDM_AUTO_DISABLE
+    if (t->_disabled) {
+        // only reached by bars that are still published to the registry, write JSON lines
+        // or have a parent to advance
+        __atomic_store_n(&t->_last_print, now_ms, __ATOMIC_RELAXED);
+        __atomic_store_n(&t->_drawn, true, __ATOMIC_RELAXED);
+        if (done && _tqdm_mark_done(t)) {
+            _tqdm_roll_up(t);
+        }
+        return;
+    }
+
+    // leave room before the line for the cursor movement, and after it for clearing and a newline
+    char frame[TQDM_MAXIMUM_LINE_SIZE + 24];
+    char *line = frame + 16;
+    unsigned int width = __atomic_load_n(&t->_term_width, __ATOMIC_RELAXED);
+    _tqdm_sample_rate(t, steps, now_ms);
+    size_t len = _tqdm_render(t, steps, now_ms, width, line);
+
+    // a redrawn line can only be compared against the previous one if the layout is the same
+    bool comparable = t->_drawn && width == t->_last_width;
+    size_t start = 0;
+    if (comparable) {
+        size_t common = MIN(len, t->_last_line_len);
+        while (start < common && line[start] == t->_last_line[start]) {
+            start++;
+        }
+    }
+
+    char *out = line;
+    char *end = line + len;
+    if (comparable && start == len && len == t->_last_line_len) {
+        // nothing visible changed
+        out = end;
+    } else if (comparable && TQDM_PARTIAL_REDRAW) {
+        // back up to the start of a utf-8 character and find its column
+        while (start > 0 && (line[start] & 0xC0) == 0x80) {
+            start--;
+        }
+        unsigned int column = 0;
+        for (size_t i = 0; i < start; i++) {
+            column += (line[i] & 0xC0) != 0x80;
+        }
+
+        char move[16];
+        size_t move_len = 0;
+        move[move_len++] = '\r';
+        if (column > 0) {
+            memcpy(move + move_len, "\033[", 2);
+            move_len += 2;
+            move_len += _tqdm_format_u64(move + move_len, column);
+            move[move_len++] = 'C';
+        }
+
+        memcpy(t->_last_line, line, len);
+        out = line + start - move_len;
+        memcpy(out, move, move_len);
+        memcpy(end, "\033[K", 3);
+        end += 3;
+    } else {
+        memcpy(t->_last_line, line, len);
+        if (t->_drawn) {
+            out = line - 4;
+            memcpy(out, "\r\033[K", 4);
+        }
+    }
+    t->_last_line_len = len;
+    t->_last_width = width;
+
+    if (done) {
+        *end++ = '\n';
+    }
+    if (end > out) {
+        write(t->_fd, out, end - out);
+    }
+
+    // update last print time to now
+    __atomic_store_n(&t->_last_print, now_ms, __ATOMIC_RELAXED);
+    __atomic_store_n(&t->_drawn, true, __ATOMIC_RELAXED);
+    if (done && _tqdm_mark_done(t)) {
+        _tqdm_roll_up(t);
+    }
+}
+
+/**
+ * @brief Helper to consume a pending terminal resize, returning true if the bar must be redrawn
+ *
+ * The terminal width is cached in the bar and only queried again after a
+ * SIGWINCH. Each bar tracks the resizes it has seen, so that every bar in a
+ * program picks up the new width.
+ */
+static bool _tqdm_consume_resize(tqdm *t) {
+#if TQDM_DYNAMIC_RESIZE
+    sig_atomic_t winch = _tqdm_winch;
+    if (__atomic_load_n(&t->_winch_seen, __ATOMIC_RELAXED) != winch &&
+        __atomic_exchange_n(&t->_winch_seen, winch, __ATOMIC_RELAXED) != winch) {
+        __atomic_store_n(&t->_term_width, _tqdm_terminal_size(t), __ATOMIC_RELAXED);
+        return true;
+    }
+#else
+    (void)t;
+#endif // TQDM_DYNAMIC_RESIZE
+    return false;
+}
+
+/// helper to read the clock for tqdm_update and redraw the bar if the interval has elapsed
+static void _tqdm_update_check(tqdm *t) {
+    // if progress bar is done, do nothing
+    if (t->_done) {
+        return;
+    }
+
+    long now_ms = _tqdm_now_ms();
+    long last_ms = t->_last_print;
+    _tqdm_schedule_check(t, t->current_steps, now_ms);
+
+    // don't skip if terminal resized in dynamic mode
+    bool force_redraw = _tqdm_consume_resize(t);
+
+    // if minimum interval not reached, skip update
+    if (t->_drawn &&        // only skip if already drawn
+        !force_redraw &&
+        now_ms - last_ms < t->min_interval_ms &&
+        t->current_steps < t->total_steps) {
+        return;
+    }
+
+    _tqdm_draw(t, t->current_steps, now_ms);
+}
+
+/**
+ * @brief Update the tqdm progress bar by a given number of steps
+ *
+ * @param t Pointer to tqdm struct to update
+ * @param step Number of steps to increment
+ */
+static inline void tqdm_update(tqdm *t, uint64_t step) {
+    // a relaxed store is a plain store, but lets background threads read the count
+    __atomic_store_n(&t->current_steps, t->current_steps + step, __ATOMIC_RELAXED);
+
+    // fast path: skip the clock read until enough steps have accumulated
+    if (t->current_steps < t->_next_check) {
+        return;
+    }
+
+    uint64_t start_ns = _tqdm_overhead_begin();
+    _tqdm_update_check(t);
+    _tqdm_overhead_end(t, start_ns);
+}
+
+/// helper to try to take a render lock without blocking
+static bool _tqdm_trylock(int *lock) {
+    return __atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) == 0;
+}
+
+/// helper to take a render lock, spinning until any redraw in flight finishes
+static void _tqdm_lock(int *lock) {
+    while (!_tqdm_trylock(lock)) {
+        sched_yield();
+    }
+}
+
+/// helper to release a render lock
+static void _tqdm_unlock(int *lock) {
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+/// helper to read the clock for tqdm_update_concurrent and redraw the bar if the interval has elapsed
+static void _tqdm_concurrent_check(tqdm *t, uint64_t steps, uint64_t step, uint64_t next) {
+    if (steps >= t->total_steps) {
+        // only the update that crossed the total draws the final frame,
+        // waiting for any redraw still in flight on another thread
+        if (steps - step < t->total_steps) {
+            _tqdm_lock(&t->_lock);
+            if (!t->_done) {
+                _tqdm_draw(t, __atomic_load_n(&t->current_steps, __ATOMIC_RELAXED), _tqdm_now_ms());
+            }
+            _tqdm_unlock(&t->_lock);
+        }
+        return;
+    }
+
+    // claim the clock read, parking the threshold at the total until it is rescheduled
+    if (!__atomic_compare_exchange_n(&t->_next_check, &next, t->total_steps, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    long now_ms = _tqdm_now_ms();
+    long last_ms = __atomic_load_n(&t->_last_print, __ATOMIC_RELAXED);
+    _tqdm_schedule_check(t, steps, now_ms);
+
+    bool force_redraw = _tqdm_consume_resize(t);
+
+    if (__atomic_load_n(&t->_drawn, __ATOMIC_RELAXED) &&
+        !force_redraw &&
+        now_ms - last_ms < t->min_interval_ms) {
+        return;
+    }
+
+    // exactly one thread wins the right to redraw for this interval
+    if (!__atomic_compare_exchange_n(&t->_last_print, &last_ms, now_ms, false,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    if (_tqdm_trylock(&t->_lock)) {
+        if (!t->_done) {
+            _tqdm_draw(t, __atomic_load_n(&t->current_steps, __ATOMIC_RELAXED), now_ms);
+        }
+        _tqdm_unlock(&t->_lock);
+    }
+}
+
+/**
+ * @brief Update the tqdm progress bar by a given number of steps from any thread
+ *
+ * Thread-safe counterpart of tqdm_update for bars shared between threads.
+ * Steps are counted with a relaxed atomic add, and only the thread crossing
+ * the next clock-read threshold consults the clock. Of the threads that find
+ * the minimum interval elapsed, exactly one wins a compare-and-swap on the
+ * last print time and redraws; the others return immediately. The update
+ * that reaches the total always draws the final frame.
+ *
+ * A bar must be updated either exclusively through this function or
+ * exclusively through tqdm_update.
+ *
+ * @param t Pointer to tqdm struct to update
+ * @param step Number of steps to increment
+ */
+static inline void tqdm_update_concurrent(tqdm *t, uint64_t step) {
+    uint64_t steps = __atomic_add_fetch(&t->current_steps, step, __ATOMIC_RELAXED);
+    uint64_t next = __atomic_load_n(&t->_next_check, __ATOMIC_RELAXED);
+
+    // fast path: skip the clock read until enough steps have accumulated
+    if (steps < next) {
+        return;
+    }
+
+    uint64_t start_ns = _tqdm_overhead_begin();
+    _tqdm_concurrent_check(t, steps, step, next);
+    _tqdm_overhead_end(t, start_ns);
+}
+
+/// helper to close a bar, for callers whose time is already counted as overhead
+static void _tqdm_close(tqdm *t) {
+    _tqdm_lock(&t->_lock);
+    uint64_t steps = __atomic_load_n(&t->current_steps, __ATOMIC_RELAXED);
+    bool closing = !t->_closed;
+    if (closing && t->_manager) {
+        _tqdm_manager_draw(t->_manager, t, steps, true, _tqdm_now_ms());
+    } else if (closing) {
+        _tqdm_draw(t, steps, _tqdm_now_ms());
+        if (!t->_closed) {
+            // stopped short of the total, so end the line ourselves
+            _tqdm_mark_done(t);
+            if (!t->_disabled) {
+                write(t->_fd, "\n", 1);
+            }
+            _tqdm_roll_up(t);
+        }
+    }
+    // bars that reach their total write their final JSON-lines record when drawn
+    if (closing && t->json_fd >= 0 && steps < t->total_steps) {
+        _tqdm_json_write(t, steps, _tqdm_now_ms(), true);
+    }
+    _tqdm_unlock(&t->_lock);
+}
+
+/**
+ * @brief Close a tqdm progress bar, drawing its final state and ending the line
+ *
+ * Bars that reach their total close themselves. This is only needed when a bar
+ * may stop short of its total, or when its final update may not be drawn
+ * (e.g. sharded bars). A bar published to the registry keeps its slot until
+ * it is closed or done. Safe to call more than once.
+ *
+ * @param t Pointer to tqdm struct to close
+ */
+static inline void tqdm_close(tqdm *t) {
+    uint64_t start_ns = _tqdm_overhead_begin();
+    _tqdm_close(t);
+    _tqdm_overhead_end(t, start_ns);
+}
+
+/**
+ * @brief Struct representing the state of a tqdm progress bar at one point in time
+ *
+ * Filled in by tqdm_snapshot. Times are in seconds and rates in steps per second.
+ */
+typedef struct {
+    /// current step count
+    uint64_t current_steps;
+    /// total number of steps, or TQDM_UNKNOWN_TOTAL
+    uint64_t total_steps;
+    /// time since the bar was started
+    double elapsed;
+    /// estimated rate, or a negative value if it is not known yet
+    double rate;
+    /// estimated time until the total is reached, or a negative value if it is not known
+    double remaining;
+    /// share of the elapsed time spent inside tqdm, summed over all updating threads,
+    /// or 0 if it is not measured (see TQDM_MEASURE_OVERHEAD)
+    double overhead;
+    /// whether the bar was completed or closed, or has reached its total
+    bool done;
+} tqdm_stats;
+
+/**
+ * @brief Read the state of a tqdm progress bar from any thread, without blocking its updaters
+ *
+ * The step count, elapsed time and rate are those of the bar's latest redraw,
+ * published together under a seqlock, and the remaining time is derived from
+ * them, so that the four values are consistent with each other. They lag the
+ * live count by at most about min_interval_ms. A bar that has not estimated a
+ * rate yet (e.g. because it is not drawn) and a closed bar report their live
+ * count instead, with the average rate over the run. It only costs a few
+ * atomic loads and one clock read, so it can be polled at high frequency.
+ *
+ * @param t Pointer to tqdm struct to read
+ * @param stats Pointer to tqdm_stats struct to fill in
+ */
+static inline void tqdm_snapshot(const tqdm *t, tqdm_stats *stats) {
+    long now_ms = _tqdm_now_ms();
+    uint64_t steps;
+    long sample_ms;
+    double rate;
+    bool closed;
+    uint32_t seq;
+    do {
+        seq = __atomic_load_n(&t->_stats_seq, __ATOMIC_ACQUIRE);
+        steps = __atomic_load_n(&t->_stats_steps, __ATOMIC_RELAXED);
+        sample_ms = __atomic_load_n(&t->_stats_ms, __ATOMIC_RELAXED);
+        __atomic_load(&t->_stats_rate, &rate, __ATOMIC_RELAXED);
+        closed = __atomic_load_n(&t->_closed, __ATOMIC_RELAXED);
+        if (closed || rate < 0) {
+            // report the final count, as of the last draw, or the count so far; read within
+            // the seqlock so that it is not mixed with a sample published in the meantime
+            steps = __atomic_load_n(&t->current_steps, __ATOMIC_RELAXED);
+            sample_ms = closed ? __atomic_load_n(&t->_last_print, __ATOMIC_RELAXED) : now_ms;
+            rate = sample_ms > t->_start ? steps / (double)(sample_ms - t->_start) : -1;
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || __atomic_load_n(&t->_stats_seq, __ATOMIC_RELAXED) != seq);
+    long elapsed_ms = sample_ms - t->_start;
+
+    stats->current_steps = steps;
+    stats->total_steps = t->total_steps;
+    stats->elapsed = elapsed_ms / 1e3;
+    stats->rate = rate < 0 ? -1 : rate * 1e3;
+    if (t->total_steps != TQDM_UNKNOWN_TOTAL && steps >= t->total_steps) {
+        stats->remaining = 0;
+    } else if (t->total_steps != TQDM_UNKNOWN_TOTAL && rate > 0) {
+        stats->remaining = (t->total_steps - steps) / rate / 1e3;
+    } else {
+        stats->remaining = -1;
+    }
+#if TQDM_MEASURE_OVERHEAD
+    stats->overhead = now_ms > t->_start
+                          ? __atomic_load_n(&t->_overhead_ns, __ATOMIC_RELAXED) / ((now_ms - t->_start) * 1e6)
+                          : 0;
+#else
+    stats->overhead = 0;
+#endif // TQDM_MEASURE_OVERHEAD
+    // parked bars that nobody closes never draw their final frame, so check the count as well
+    stats->done = closed ||
+                  (t->total_steps != TQDM_UNKNOWN_TOTAL && steps >= t->total_steps);
+}
+
+/**
+ * @brief Render a tqdm progress bar into a caller-provided buffer, without writing it out
+ *
+ * Formats the same line as a redraw would, for a line of `width` columns, so
+ * that it can be embedded in a custom status display or log line. Makes no
+ * system calls besides reading the monotonic clock (a vDSO call on Linux), and
+ * feeds the bar's ETA model like a redraw does, so it must be called from the
+ * thread updating the bar; other threads should use tqdm_snapshot. A bar that
+ * is only rendered this way can be advanced by adding to its `current_steps`
+ * directly, so that it never draws itself.
+ *
+ * Like snprintf, the output is null-terminated and truncated to fit in `size`
+ * bytes, at a character boundary, and the full length of the line is returned.
+ *
+ * @param t Pointer to tqdm struct to render
+ * @param width Number of columns the line should fill
+ * @param buffer Buffer to write the line to
+ * @param size Size of the buffer in bytes
+ * @return Length of the full line in bytes, excluding the terminating null
+ */
+static inline size_t tqdm_render(tqdm *t, unsigned int width, char *buffer, size_t size) {
+    char line[TQDM_MAXIMUM_LINE_SIZE];
+    uint64_t start_ns = _tqdm_overhead_begin();
+    uint64_t steps = __atomic_load_n(&t->current_steps, __ATOMIC_RELAXED);
+    long now_ms = _tqdm_now_ms();
+    // a managed bar is also sampled by whichever thread redraws its manager's block
+    if (t->_manager) {
+        _tqdm_manager_lock(t->_manager);
+    }
+    _tqdm_sample_rate(t, steps, now_ms);
+    size_t len = _tqdm_render(t, steps, now_ms,
+                              CLAMP(width, TQDM_MINIMUM_TERMINAL_WIDTH, TQDM_MAXIMUM_TERMINAL_WIDTH), line);
+    if (t->_manager) {
+        _tqdm_manager_unlock(t->_manager);
+    }
+    _tqdm_overhead_end(t, start_ns);
+
+    if (size > 0) {
+        size_t n = MIN(len, size - 1);
+        // don't cut a utf-8 character in half
+        if (n < len) {
+            while (n > 0 && (line[n] & 0xC0) == 0x80) {
+                n--;
+            }
+        }
+        memcpy(buffer, line, n);
+        buffer[n] = '\0';
+    }
+    return len;
+}
+
+/* ==================== multiple bars ==================== */
+
+/// maximum number of bars a manager can draw
+#ifndef TQDM_MANAGER_MAX_BARS
+#define TQDM_MANAGER_MAX_BARS 32
+#endif
+
+/// size of a manager's frame buffer; frames that don't fit are written in several parts
+#ifndef TQDM_MANAGER_FRAME_SIZE
+#define TQDM_MANAGER_FRAME_SIZE 65536
+#endif
+
+/**
+ * @brief Struct representing a stacked block of tqdm progress bars
+ *
+ * A manager owns the lines its bars are drawn on. Whenever one of its bars is
+ * due for a redraw, all of them are composed into one frame, which moves the
+ * cursor back to the top of the block and rewrites each line, and is written
+ * with a single call.
+ */
+typedef struct tqdm_manager {
+    /* user-facing */
+    /// bars in display order, from top to bottom
+    tqdm *bars[TQDM_MANAGER_MAX_BARS];
+    /// number of bars
+    unsigned int num_bars;
+    /// minimum interval between redraws of the block (in milliseconds)
+    uint32_t min_interval_ms;
+
+    /* for internal bookkeeping */
+    /// time in ms when the block was last printed, based on CLOCK_MONOTONIC
+    long _last_print;
+    /// number of lines of the block currently on screen, with the cursor on the last one
+    unsigned int _lines_drawn;
+    /// internal boolean to track if the block was disabled because its output is not a terminal
+    bool _disabled;
+    /// render lock taken by the thread redrawing the block
+    int _lock;
+    /// file descriptor to write to (STDERR_FILENO by default)
+    int _fd;
+    /// buffer the frame is composed in
+    char _frame[TQDM_MANAGER_FRAME_SIZE];
+} tqdm_manager;
+
+/**
+ * @brief Initialise a manager for a stacked block of tqdm progress bars
+ *
+ * @param m Pointer to tqdm_manager struct to initialise
+ * @param min_interval_ms Minimum interval between redraws of the block (in milliseconds)
+ */
+static inline void tqdm_manager_init(tqdm_manager *m, uint32_t min_interval_ms) {
+    m->num_bars = 0;
+    m->min_interval_ms = min_interval_ms;
+    m->_last_print = 0;
+    m->_lines_drawn = 0;
+    m->_disabled = false;
+    m->_lock = 0;
+    m->_fd = STDERR_FILENO;
+}
+
+/// helper to find the line of a bar in a manager's block, or num_bars if it is not there
+static unsigned int _tqdm_manager_find(const tqdm_manager *m, const tqdm *t) {
+    unsigned int i = 0;
+    while (i < m->num_bars && m->bars[i] != t) {
+        i++;
+    }
+    return i;
+}
+
+/// helper to insert a bar into a manager's block at a given line, with the manager's lock held
+static bool _tqdm_manager_insert(tqdm_manager *m, tqdm *t, unsigned int line) {
+    if (m->num_bars >= TQDM_MANAGER_MAX_BARS) {
+        return false;
+    }
+    memmove(&m->bars[line + 1], &m->bars[line], (m->num_bars - line) * sizeof(tqdm *));
+    m->bars[line] = t;
+    m->num_bars++;
+    t->_manager = m;
+    if (m->_disabled) {
+        _tqdm_disable(t);
+    }
+    return true;
+}
+
+/// helper to remove the bar on a given line from a manager's block, with the manager's lock held
+static void _tqdm_manager_remove(tqdm_manager *m, unsigned int line) {
+    m->num_bars--;
+    memmove(&m->bars[line], &m->bars[line + 1], (m->num_bars - line) * sizeof(tqdm *));
+}
+
+/**
+ * @brief Add a tqdm progress bar to the bottom of a manager's block
+ *
+ * The bar must have been initialised with tqdm_init, and must not be drawn
+ * yet. From then on, its updates redraw the whole block.
+ *
+ * @param m Pointer to tqdm_manager struct to add to
+ * @param t Pointer to tqdm struct to add
+ * @return true on success, false if the manager already holds TQDM_MANAGER_MAX_BARS bars
+ */
+static inline bool tqdm_manager_add(tqdm_manager *m, tqdm *t) {
+    _tqdm_lock(&m->_lock);
+    bool added = _tqdm_manager_insert(m, t, m->num_bars);
+    _tqdm_unlock(&m->_lock);
+    return added;
+}
+
+/// helper to write out the part of the frame composed so far
+static size_t _tqdm_manager_flush(tqdm_manager *m, size_t len) {
+    if (len > 0) {
+        write(m->_fd, m->_frame, len);
+    }
+    return 0;
+}
+
+/// helper to compose every bar of a manager into one frame and write it, with its lock held
+static void _tqdm_manager_render(tqdm_manager *m, long now_ms) {
+#if TQDM_AUTO_DISABLE
+    // as for single bars, stop drawing if the output is not a terminal
+    if (m->_lines_drawn == 0 && !isatty(m->_fd)) {
+        m->_disabled = true;
+        for (unsigned int i = 0; i < m->num_bars; i++) {
+            _tqdm_disable(m->bars[i]);
+        }
+        return;
+    }
+#endif // TQDM_AUTO_DISABLE
+
+    unsigned int num_bars = m->num_bars;
+    size_t len = 0;
+    bool done = true;
+
+    // move back to the first line of the block
+    if (m->_lines_drawn > 1) {
+        memcpy(m->_frame, "\033[", 2);
+        len = 2;
+        len += _tqdm_format_u64(m->_frame + len, m->_lines_drawn - 1);
+        m->_frame[len++] = 'A';
+    }
+
+    for (unsigned int i = 0; i < num_bars; i++) {
+        tqdm *t = m->bars[i];
+        if (TQDM_MANAGER_FRAME_SIZE - len < TQDM_MAXIMUM_LINE_SIZE + 8) {
+            len = _tqdm_manager_flush(m, len);
+        }
+        if (i > 0) {
+            m->_frame[len++] = '\n';
+        }
+        memcpy(m->_frame + len, "\r\033[K", 4);
+        len += 4;
+
+        // finished bars keep showing the time they completed at
+        bool bar_done = __atomic_load_n(&t->_done, __ATOMIC_RELAXED);
+        long bar_now_ms = bar_done ? __atomic_load_n(&t->_last_print, __ATOMIC_RELAXED) : now_ms;
+        uint64_t bar_steps = __atomic_load_n(&t->current_steps, __ATOMIC_RELAXED);
+        _tqdm_sample_rate(t, bar_steps, bar_now_ms);
+        len += _tqdm_render(t, bar_steps, bar_now_ms,
+                            __atomic_load_n(&t->_term_width, __ATOMIC_RELAXED), m->_frame + len);
+        done = done && bar_done;
+    }
+
+    // clear lines left over from a taller block
+    if (m->_lines_drawn > num_bars) {
+        memcpy(m->_frame + len, "\n\033[J\033[1A", 8);
+        len += 8;
+    }
+
+    // once every bar is done, leave the cursor below the block
+    if (done && num_bars > 0) {
+        m->_frame[len++] = '\n';
+        m->_lines_drawn = 0;
+    } else {
+        m->_lines_drawn = num_bars;
+    }
+    _tqdm_manager_flush(m, len);
+    __atomic_store_n(&m->_last_print, now_ms, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Helper to take a manager's lock from code that only sees its forward declaration
+ *
+ * Whichever thread redraws the block samples the ETA model of every bar in it,
+ * so a bar's own thread must hold the same lock to sample it outside a redraw.
+ */
+static void _tqdm_manager_lock(tqdm_manager *m) {
+    _tqdm_lock(&m->_lock);
+}
+
+/// helper to release a manager's lock taken with _tqdm_manager_lock
+static void _tqdm_manager_unlock(tqdm_manager *m) {
+    _tqdm_unlock(&m->_lock);
+}
+
+/**
+ * @brief Helper to draw a managed bar for a given step count by redrawing its manager's block
+ *
+ * Updates from different bars are coalesced: the block is redrawn at most once
+ * per interval, except when a bar completes, which is always drawn.
+ */
+static void _tqdm_manager_draw(tqdm_manager *m, tqdm *t, uint64_t steps, bool done, long now_ms) {
+    (void)steps; // the block is rendered from every bar's latest count
+    __atomic_store_n(&t->_last_print, now_ms, __ATOMIC_RELAXED);
+    __atomic_store_n(&t->_drawn, true, __ATOMIC_RELAXED);
+    bool completed = done && _tqdm_mark_done(t);
+
+    if (completed) {
+        _tqdm_lock(&m->_lock);
+        // bars that don't leave give their line back to the block
+        unsigned int line = _tqdm_manager_find(m, t);
+        if (!t->leave && line < m->num_bars) {
+            _tqdm_manager_remove(m, line);
+        }
+    } else if (now_ms - __atomic_load_n(&m->_last_print, __ATOMIC_RELAXED) < m->min_interval_ms ||
+               !_tqdm_trylock(&m->_lock)) {
+        return;
+    }
+    if (!m->_disabled) {
+        _tqdm_manager_render(m, now_ms);
+    }
+    _tqdm_unlock(&m->_lock);
+
+    // advance the parent only once the manager's lock is released, as it may redraw the block
+    if (completed) {
+        _tqdm_roll_up(t);
+    }
+}
+
+/// helper to check whether a bar is nested, directly or not, under another
+static bool _tqdm_is_descendant(const tqdm *t, const tqdm *ancestor) {
+    for (t = t->_parent; t != NULL; t = t->_parent) {
+        if (t == ancestor) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Initialise a tqdm progress bar nested under a parent bar
+ *
+ * Each time the child completes, its parent advances by one step, so the
+ * parent should not also be updated directly. The parent must be drawn by a
+ * manager: the child is drawn on the line below the parent's existing
+ * children, and a child that doesn't leave is removed from the block once
+ * done. A child struct may be re-initialised for every iteration of the
+ * parent, replacing its previous line.
+ *
+ * If the parent has no manager, the child would have to share the parent's
+ * line, so it is never drawn, but it still counts its steps and advances
+ * its parent.
+ *
+ * Usage:
+ * ```
+ * tqdm_init(&epochs, num_epochs, "Training", 50);
+ * tqdm_manager_add(&manager, &epochs);
+ * for (int e = 0; e < num_epochs; e++) {
+ *     tqdm_init_child(&batches, &epochs, num_batches, "Epoch", false);
+ *     for (int b = 0; b < num_batches; b++) {
+ *         train(b);
+ *         tqdm_update(&batches, 1);
+ *     }
+ * }
+ * ```
+ *
+ * @param t Pointer to tqdm struct to initialise
+ * @param parent Pointer to the parent tqdm struct
+ * @param total_steps Total number of steps
+ * @param description Description string to display alongside the progress bar
+ * @param leave Whether to keep the child on screen once done
+ * @return true on success, false if the parent has no manager or it already holds
+ *         TQDM_MANAGER_MAX_BARS bars, in which case the child is not drawn
+ */
+static inline bool tqdm_init_child(tqdm *t, tqdm *parent, uint64_t total_steps, const char *description, bool leave) {
+    tqdm_manager *m = parent->_manager;
+
+    // a re-initialised child replaces its previous line
+    if (m) {
+        _tqdm_lock(&m->_lock);
+        unsigned int line = _tqdm_manager_find(m, t);
+        if (line < m->num_bars) {
+            _tqdm_manager_remove(m, line);
+        }
+        _tqdm_unlock(&m->_lock);
+    }
+
+    tqdm_init(t, total_steps, description, parent->min_interval_ms);
+    t->_parent = parent;
+    t->leave = leave;
+
+    if (m == NULL) {
+        // the parent owns the current line, so the child is kept off the terminal when drawn
+        return false;
+    }
+
+    _tqdm_lock(&m->_lock);
+    unsigned int line = _tqdm_manager_find(m, parent) + 1;
+    while (line < m->num_bars && _tqdm_is_descendant(m->bars[line], parent)) {
+        line++;
+    }
+    bool added = _tqdm_manager_insert(m, t, MIN(line, m->num_bars));
+    _tqdm_unlock(&m->_lock);
+    return added;
+}
+
+/**
+ * @brief Close a manager, drawing the final state of every bar and leaving the cursor below the block
+ *
+ * Only needed when some bars may stop short of their totals.
+ *
+ * @param m Pointer to tqdm_manager struct to close
+ */
+static inline void tqdm_manager_close(tqdm_manager *m) {
+    // closing a bar can remove it or its parent from the block, so look for the
+    // next bar to close afresh each time, starting from the deepest children
+    for (;;) {
+        tqdm *t = NULL;
+        _tqdm_lock(&m->_lock);
+        for (unsigned int i = m->num_bars; i > 0 && t == NULL; i--) {
+            if (!__atomic_load_n(&m->bars[i - 1]->_closed, __ATOMIC_RELAXED)) {
+                t = m->bars[i - 1];
+            }
+        }
+        _tqdm_unlock(&m->_lock);
+        if (t == NULL) {
+            return;
+        }
+        tqdm_close(t);
+    }
+}
+
+/* ==================== sharded bars ==================== */
+
+/**
+ * @brief Number of counter slots in a sharded bar.
+ * Threads are assigned slots round-robin; more threads than slots still count
+ * correctly but share cache lines.
+ */
+#ifndef TQDM_SHARDS
+#define TQDM_SHARDS 64
+#endif
+
+#define TQDM_CACHE_LINE 64
+
+/// per-thread counter slot, padded to a cache line to avoid false sharing
+typedef struct {
+    /// steps counted through this slot
+    uint64_t steps;
+    /// slot step count at which the clock is next read
+    uint64_t next_check;
+    /// slot step count when the clock was last read
+    uint64_t last_check_steps;
+    /// time in ms when the clock was last read through this slot
+    long last_check;
+    /// number of slot steps between clock reads
+    uint64_t miniters;
+} __attribute__((aligned(TQDM_CACHE_LINE))) _tqdm_shard;
+
+/**
+ * @brief Struct representing a tqdm progress bar updated through per-thread counters
+ *
+ * Each updating thread increments its own cache-line-padded slot, so the cost
+ * of an update does not grow with the number of threads. The slots are summed
+ * into the underlying bar only when it is redrawn, which renders exactly like
+ * a single-threaded bar.
+ */
+typedef struct {
+    /// underlying progress bar, whose current_steps is the sum of the slots as of the last redraw
+    tqdm bar;
+    /// counter slots
+    _tqdm_shard _shards[TQDM_SHARDS];
+} tqdm_sharded;
+
+/// slot index of the calling thread, assigned on its first sharded update
+static __thread int _tqdm_shard_id = -1;
+
+/// round-robin counter for assigning slots to threads
+static unsigned int _tqdm_shard_next = 0;
+
+/// helper to get the slot index of the calling thread
+static int _tqdm_shard_index(void) {
+    if (_tqdm_shard_id < 0) {
+        _tqdm_shard_id = __atomic_fetch_add(&_tqdm_shard_next, 1, __ATOMIC_RELAXED) % TQDM_SHARDS;
+    }
+    return _tqdm_shard_id;
+}
+
+/// helper to sum the slots of a sharded bar
+static uint64_t _tqdm_sharded_sum(tqdm_sharded *ts) {
+    uint64_t sum = 0;
+    for (int i = 0; i < TQDM_SHARDS; i++) {
+        sum += __atomic_load_n(&ts->_shards[i].steps, __ATOMIC_RELAXED);
+    }
+    return sum;
+}
+
+/**
+ * @brief Initialise a sharded tqdm progress bar
+ *
+ * @param ts Pointer to tqdm_sharded struct to initialise
+ * @param total_steps Total number of steps
+ * @param description Description string to display alongside the progress bar
+ * @param min_interval_ms Minimum interval between updates (in milliseconds)
+ */
+static inline void tqdm_sharded_init(tqdm_sharded *ts, uint64_t total_steps, const char *description, uint32_t min_interval_ms) {
+    tqdm_init(&ts->bar, total_steps, description, min_interval_ms);
+    memset(ts->_shards, 0, sizeof(ts->_shards));
+    for (int i = 0; i < TQDM_SHARDS; i++) {
+        ts->_shards[i].last_check = ts->bar._start;
+        ts->_shards[i].miniters = 1;
+    }
+}
+
+/// helper to read the clock for a slot and redraw the bar if the interval has elapsed
+static void _tqdm_sharded_check(tqdm_sharded *ts, _tqdm_shard *shard, uint64_t local, uint64_t next) {
+    tqdm *t = &ts->bar;
+
+    // claim the clock read in case several threads share this slot
+    if (!__atomic_compare_exchange_n(&shard->next_check, &next, UINT64_MAX, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    // once done, leave the slot parked on the fast path
+    if (__atomic_load_n(&t->_done, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    long now_ms = _tqdm_now_ms();
+    uint64_t stride = t->miniters;
+    if (stride == 0) {
+        stride = _tqdm_adapt_stride(shard->miniters, local - shard->last_check_steps,
+                                    now_ms - shard->last_check, t->min_interval_ms);
+        shard->miniters = stride;
+    }
+    shard->last_check = now_ms;
+    shard->last_check_steps = local;
+    __atomic_store_n(&shard->next_check, local + stride, __ATOMIC_RELEASE);
+
+    uint64_t steps = _tqdm_sharded_sum(ts);
+    if (steps >= t->total_steps) {
+        __atomic_store_n(&t->current_steps, steps, __ATOMIC_RELAXED);
+        _tqdm_close(t);
+        return;
+    }
+
+    long last_ms = __atomic_load_n(&t->_last_print, __ATOMIC_RELAXED);
+    bool force_redraw = _tqdm_consume_resize(t);
+
+    if (__atomic_load_n(&t->_drawn, __ATOMIC_RELAXED) &&
+        !force_redraw &&
+        now_ms - last_ms < t->min_interval_ms) {
+        return;
+    }
+
+    // exactly one thread wins the right to redraw for this interval
+    if (!__atomic_compare_exchange_n(&t->_last_print, &last_ms, now_ms, false,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    if (_tqdm_trylock(&t->_lock)) {
+        if (!t->_done) {
+            __atomic_store_n(&t->current_steps, steps, __ATOMIC_RELAXED);
+            _tqdm_draw(t, steps, now_ms);
+        }
+        _tqdm_unlock(&t->_lock);
+    }
+}
+
+/**
+ * @brief Update a sharded tqdm progress bar by a given number of steps from any thread
+ *
+ * Counts the steps in the calling thread's slot. Since each slot only reads
+ * the clock periodically, the last steps of a run may not be drawn: call
+ * tqdm_sharded_close once all updating threads have finished.
+ *
+ * @param ts Pointer to tqdm_sharded struct to update
+ * @param step Number of steps to increment
+ */
+static inline void tqdm_sharded_update(tqdm_sharded *ts, uint64_t step) {
+    _tqdm_shard *shard = &ts->_shards[_tqdm_shard_index()];
+    uint64_t local = __atomic_add_fetch(&shard->steps, step, __ATOMIC_RELAXED);
+    uint64_t next = __atomic_load_n(&shard->next_check, __ATOMIC_RELAXED);
+
+    // fast path: skip the clock read until enough steps have accumulated in this slot
+    if (local < next) {
+        return;
+    }
+
+    uint64_t start_ns = _tqdm_overhead_begin();
+    _tqdm_sharded_check(ts, shard, local, next);
+    _tqdm_overhead_end(&ts->bar, start_ns);
+}
+
+/**
+ * @brief Close a sharded tqdm progress bar, drawing the sum of all slots
+ *
+ * @param ts Pointer to tqdm_sharded struct to close
+ */
+static inline void tqdm_sharded_close(tqdm_sharded *ts) {
+    __atomic_store_n(&ts->bar.current_steps, _tqdm_sharded_sum(ts), __ATOMIC_RELAXED);
+    tqdm_close(&ts->bar);
+}
+
+/* ==================== shared bars ==================== */
+
+// anonymous mappings are not part of POSIX, so their flag is not declared in strict modes
+// such as -std=c11 -D_POSIX_C_SOURCE=200809L, where shared bars are left out
+#ifdef MAP_ANONYMOUS
+
+/**
+ * @brief Create a tqdm progress bar in shared memory, to be updated by forked processes
+ *
+ * The bar lives in an anonymous MAP_SHARED mapping, so it is shared with every
+ * process forked after it is created. Workers count steps with
+ * tqdm_shared_update, which is a single atomic addition and never draws (they
+ * must not call tqdm_update, whose addition is not atomic), while
+ * the process that created the bar draws it with tqdm_shared_refresh (or a
+ * tqdm_renderer), giving one bar and one rate for the whole job. The
+ * description must stay valid at the same address in every process, as
+ * string literals and memory allocated before forking do.
+ *
+ * Usage:
+ * ```
+ * tqdm *bar = tqdm_shared_create(n, "Processing", 100);
+ * for (int w = 0; w < workers; w++) {
+ *     if (fork() == 0) {
+ *         for (int i = w; i < n; i += workers) {
+ *             process(i);
+ *             tqdm_shared_update(bar, 1);
+ *         }
+ *         _exit(0);
+ *     }
+ * }
+ * while (waitpid(-1, NULL, WNOHANG) >= 0) {
+ *     tqdm_shared_refresh(bar);
+ *     usleep(10000);
+ * }
+ * tqdm_shared_close(bar);
+ * ```
+ *
+ * @param total_steps Total number of steps, or TQDM_UNKNOWN_TOTAL if not known
+ * @param description Description string to display alongside the progress bar
+ * @param min_interval_ms Minimum interval between redraws (in milliseconds)
+ * @return Pointer to the shared bar, or NULL if the mapping could not be created
+ */
+static inline tqdm *tqdm_shared_create(uint64_t total_steps, const char *description, uint32_t min_interval_ms) {
+    void *p = mmap(NULL, sizeof(tqdm), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+
+    tqdm *t = (tqdm *)p;
+    tqdm_init(t, total_steps, description, min_interval_ms);
+    // park the update fast path so that a stray tqdm_update never draws from a worker;
+    // it would still lose counts, as its addition is not atomic across processes
+    t->_next_check = UINT64_MAX;
+    return t;
+}
+
+/**
+ * @brief Add steps to a shared tqdm progress bar, from any process or thread
+ *
+ * @param t Pointer to tqdm struct created by tqdm_shared_create
+ * @param step Number of steps to add
+ */
+static inline void tqdm_shared_update(tqdm *t, uint64_t step) {
+    __atomic_fetch_add(&t->current_steps, step, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Redraw a shared tqdm progress bar if `min_interval_ms` has passed
+ *
+ * Must only be called from one process, usually the one that created the bar.
+ * Draws the final frame once the total is reached.
+ *
+ * @param t Pointer to tqdm struct created by tqdm_shared_create
+ */
+static inline void tqdm_shared_refresh(tqdm *t) {
+    if (__atomic_load_n(&t->_done, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    uint64_t steps = __atomic_load_n(&t->current_steps, __ATOMIC_RELAXED);
+    long now_ms = _tqdm_now_ms();
+    bool force_redraw = _tqdm_consume_resize(t) || !t->_drawn || steps >= t->total_steps;
+    if (force_redraw || now_ms - t->_last_print >= t->min_interval_ms) {
+        uint64_t start_ns = _tqdm_overhead_begin();
+        _tqdm_draw(t, steps, now_ms);
+        _tqdm_overhead_end(t, start_ns);
+    }
+}
+
+/**
+ * @brief Close a shared tqdm progress bar, drawing its final frame and unmapping it
+ *
+ * Must be called once, by the process that created the bar, after the
+ * workers are done. Workers' copies of the mapping are unmapped when they exit.
+ *
+ * @param t Pointer to tqdm struct created by tqdm_shared_create
+ */
+static inline void tqdm_shared_close(tqdm *t) {
+    tqdm_close(t);
+    munmap(t, sizeof(tqdm));
+}
+#endif // MAP_ANONYMOUS
+
+#if TQDM_THREADS
+/* ==================== background rendering ==================== */
+
+/**
+ * @brief Struct representing a background thread that renders a tqdm progress bar
+ *
+ * While a renderer is running, updates to its bar only bump the step count:
+ * the renderer thread owns the clock, formatting and output, redrawing the
+ * bar every `min_interval_ms`.
+ */
+typedef struct {
+    /// progress bar being rendered
+    tqdm *bar;
+
+    /* for internal bookkeeping */
+    /// external counter sampled into the bar's step count every frame, or NULL
+    const uint64_t *_counter;
+    /// renderer thread
+    pthread_t _thread;
+    /// mutex protecting _stop
+    pthread_mutex_t _mutex;
+    /// condition variable signalled to wake the renderer thread early
+    pthread_cond_t _cond;
+    /// internal boolean set to ask the renderer thread to exit
+    bool _stop;
+} tqdm_renderer;
+
+/// helper to convert a time in milliseconds to a timespec
+static struct timespec _tqdm_ms_to_timespec(long ms) {
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000;
+    return ts;
+}
+
+/// helper to read the step count of a rendered bar, sampling its external counter if it has one
+static uint64_t _tqdm_renderer_sample(tqdm_renderer *r) {
+    if (r->_counter) {
+        __atomic_store_n(&r->bar->current_steps, __atomic_load_n(r->_counter, __ATOMIC_RELAXED),
+                         __ATOMIC_RELAXED);
+    }
+    return __atomic_load_n(&r->bar->current_steps, __ATOMIC_RELAXED);
+}
+
+/// entry point of the renderer thread
+static void *_tqdm_renderer_main(void *arg) {
+    tqdm_renderer *r = (tqdm_renderer *)arg;
+    tqdm *t = r->bar;
+    long period_ms = MAX(t->min_interval_ms, 1);
+    bool stop = false;
+
+    while (!stop) {
+        uint64_t steps = _tqdm_renderer_sample(r);
+        long now_ms = _tqdm_now_ms();
+        if (steps >= t->total_steps || __atomic_load_n(&t->_done, __ATOMIC_RELAXED)) {
+            break;
+        }
+        uint64_t start_ns = _tqdm_overhead_begin();
+        _tqdm_consume_resize(t);
+        _tqdm_draw(t, steps, now_ms);
+        _tqdm_overhead_end(t, start_ns);
+
+        // sleep until the next frame, unless asked to stop
+        struct timespec deadline = _tqdm_ms_to_timespec(now_ms + period_ms);
+        pthread_mutex_lock(&r->_mutex);
+        while (!r->_stop &&
+               pthread_cond_timedwait(&r->_cond, &r->_mutex, &deadline) == 0) {
+            // spurious wakeup, keep waiting
+        }
+        stop = r->_stop;
+        pthread_mutex_unlock(&r->_mutex);
+    }
+
+    // draw the final frame
+    _tqdm_renderer_sample(r);
+    tqdm_close(t);
+    return NULL;
+}
+
+/// helper to start a renderer thread, optionally sampling an external counter
+static int _tqdm_renderer_start(tqdm_renderer *r, tqdm *t, const uint64_t *counter) {
+    r->bar = t;
+    r->_counter = counter;
+    r->_stop = false;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&r->_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&r->_mutex, NULL);
+
+    // park the update fast path: updates no longer read the clock or draw
+    __atomic_store_n(&t->_next_check, UINT64_MAX, __ATOMIC_RELAXED);
+
+    int err = pthread_create(&r->_thread, NULL, _tqdm_renderer_main, r);
+    if (err != 0) {
+        // fall back to rendering inline, unless nothing calls update to do so
+        if (!counter) {
+            __atomic_store_n(&t->_next_check, 0, __ATOMIC_RELAXED);
+        }
+        pthread_cond_destroy(&r->_cond);
+        pthread_mutex_destroy(&r->_mutex);
+    }
+    return err;
+}
+
+/**
+ * @brief Start rendering a tqdm progress bar from a background thread
+ *
+ * Must be called after tqdm_init and before the first update. Works with bars
+ * updated through tqdm_update or tqdm_update_concurrent. The renderer draws
+ * the final frame once the total is reached, but tqdm_renderer_stop must still
+ * be called to join the thread.
+ *
+ * @param r Pointer to tqdm_renderer struct to initialise
+ * @param t Pointer to tqdm struct to render
+ * @return 0 on success, or an error number if the thread could not be created
+ */
+static inline int tqdm_renderer_start(tqdm_renderer *r, tqdm *t) {
+    return _tqdm_renderer_start(r, t, NULL);
+}
+
+/**
+ * @brief Start monitoring an external counter with a tqdm progress bar
+ *
+ * A background thread samples the counter every `min_interval_ms` and renders
+ * the bar from it, so the code incrementing the counter needs no tqdm calls at
+ * all. The counter may be a plain uint64_t or one updated with atomics; in C++,
+ * a std::atomic<uint64_t> can be passed directly. An optimising compiler may
+ * keep a plain counter in a register for the whole loop, so increment it with
+ * a relaxed atomic store (which costs nothing extra) to see it move. The bar
+ * must not be updated otherwise. Stop with tqdm_renderer_stop.
+ *
+ * Usage:
+ * ```
+ * tqdm_init(&bar, n, "Hashing", 100);
+ * tqdm_monitor_start(&monitor, &bar, &hashed);
+ * for (uint64_t i = 0; i < n; i++) {
+ *     hash(i);
+ *     __atomic_store_n(&hashed, hashed + 1, __ATOMIC_RELAXED);
+ * }
+ * tqdm_renderer_stop(&monitor);
+ * ```
+ *
+ * @param r Pointer to tqdm_renderer struct to initialise
+ * @param t Pointer to tqdm struct to render
+ * @param counter Pointer to the counter to sample, which must outlive the monitor
+ * @return 0 on success, or an error number if the thread could not be created
+ */
+static inline int tqdm_monitor_start(tqdm_renderer *r, tqdm *t, const uint64_t *counter) {
+    return _tqdm_renderer_start(r, t, counter);
+}
+
+/**
+ * @brief Stop a background renderer, drawing the final frame and joining its thread
+ *
+ * @param r Pointer to tqdm_renderer struct to stop
+ */
+static inline void tqdm_renderer_stop(tqdm_renderer *r) {
+    pthread_mutex_lock(&r->_mutex);
+    r->_stop = true;
+    pthread_cond_signal(&r->_cond);
+    pthread_mutex_unlock(&r->_mutex);
+
+    pthread_join(r->_thread, NULL);
+    pthread_cond_destroy(&r->_cond);
+    pthread_mutex_destroy(&r->_mutex);
+}
+
+/* ==================== metrics exporter ==================== */
+
+/// maximum number of bars an exporter can export
+#ifndef TQDM_EXPORTER_MAX_BARS
+#define TQDM_EXPORTER_MAX_BARS 32
+#endif
+
+/// size of an exporter's buffer for the metrics text; bars that don't fit are left out
+#ifndef TQDM_EXPORTER_BUFFER_SIZE
+#define TQDM_EXPORTER_BUFFER_SIZE 65536
+#endif
+
+/// maximum number of bytes of a description used as a metric label
+#define TQDM_EXPORTER_LABEL_SIZE 128
+
+/**
+ * @brief Struct representing a background thread exporting bars as Prometheus metrics
+ *
+ * The exporter reads its bars with tqdm_snapshot, so it never blocks the
+ * threads updating them. Metrics are written in the Prometheus text format,
+ * either to a file for node_exporter's textfile collector, replaced
+ * atomically every `interval_ms`, or served over HTTP on a Unix socket, or
+ * both.
+ */
+typedef struct {
+    /// bars being exported
+    tqdm *bars[TQDM_EXPORTER_MAX_BARS];
+    /// number of bars being exported
+    unsigned int num_bars;
+    /// file to write the metrics to (should end in .prom for node_exporter), or NULL
+    const char *textfile_path;
+    /// Unix socket to serve the metrics on, or NULL
+    const char *socket_path;
+    /// interval between updates of the textfile (in milliseconds)
+    uint32_t interval_ms;
+
+    /* for internal bookkeeping */
+    /// exporter thread
+    pthread_t _thread;
+    /// mutex protecting bars and num_bars once the exporter is running
+    pthread_mutex_t _mutex;
+    /// listening socket, or -1
+    int _listen_fd;
+    /// pipe written to by tqdm_exporter_stop to wake the exporter thread
+    int _wake[2];
+    /// buffer the metrics text is composed in
+    char _buffer[TQDM_EXPORTER_BUFFER_SIZE];
+} tqdm_exporter;
+
+/**
+ * @brief Initialise a Prometheus metrics exporter
+ *
+ * Set `textfile_path` and/or `socket_path` after initialisation, add bars
+ * with tqdm_exporter_add and start the exporter with tqdm_exporter_start.
+ *
+ * @param e Pointer to tqdm_exporter struct to initialise
+ * @param interval_ms Interval between updates of the textfile (in milliseconds)
+ */
+static inline void tqdm_exporter_init(tqdm_exporter *e, uint32_t interval_ms) {
+    e->num_bars = 0;
+    e->textfile_path = NULL;
+    e->socket_path = NULL;
+    e->interval_ms = interval_ms;
+    e->_listen_fd = -1;
+    e->_wake[0] = e->_wake[1] = -1;
+    pthread_mutex_init(&e->_mutex, NULL);
+}
+
+/**
+ * @brief Add a tqdm progress bar to the bars exported by an exporter
+ *
+ * Safe to call while the exporter is running. The bar must stay valid until
+ * the exporter is stopped.
+ *
+ * @param e Pointer to tqdm_exporter struct to add to
+ * @param t Pointer to tqdm struct to export
+ * @return true on success, false if the exporter already holds TQDM_EXPORTER_MAX_BARS bars
+ */
+static inline bool tqdm_exporter_add(tqdm_exporter *e, tqdm *t) {
+    pthread_mutex_lock(&e->_mutex);
+    bool added = e->num_bars < TQDM_EXPORTER_MAX_BARS;
+    if (added) {
+        e->bars[e->num_bars++] = t;
+    }
+    pthread_mutex_unlock(&e->_mutex);
+    return added;
+}
+
+/// helper to append a string to a metrics buffer, returning the new length
+static size_t _tqdm_exporter_append(char *out, size_t len, const char *s, size_t n) {
+    memcpy(out + len, s, n);
+    return len + n;
+}
+
+/// helper to append a sample of one metric for one bar, e.g. tqdm_steps{id="0",bar="..."} 42
+static size_t _tqdm_exporter_sample(char *out, size_t len, const char *metric, unsigned int id,
+                                    const char *label, size_t label_length, double value, bool integral) {
+    len = _tqdm_exporter_append(out, len, metric, strlen(metric));
+    len = _tqdm_exporter_append(out, len, "{id=\"", 5);
+    len += _tqdm_format_u64(out + len, id);
+    len = _tqdm_exporter_append(out, len, "\",bar=\"", 7);
+    len = _tqdm_exporter_append(out, len, label, label_length);
+    len = _tqdm_exporter_append(out, len, "\"} ", 3);
+    len += integral ? _tqdm_format_u64(out + len, (uint64_t)value) : _tqdm_format_fixed2(out + len, value);
+    out[len++] = '\n';
+    return len;
+}
+
+/**
+ * @brief Helper to compose the metrics of every exported bar in the Prometheus text format
+ *
+ * Each bar is labelled with its index in the exporter and its escaped
+ * description. The total and remaining time are left out while unknown.
+ *
+ * @return Length of the metrics text in e->_buffer
+ */
+static size_t _tqdm_exporter_format(tqdm_exporter *e) {
+    static const char *const metrics[][2] = {
+        { "tqdm_steps", "Current step count of the progress bar." },
+        { "tqdm_total_steps", "Total number of steps of the progress bar." },
+        { "tqdm_elapsed_seconds", "Time since the progress bar was started." },
+        { "tqdm_rate", "Estimated rate of the progress bar in steps per second." },
+        { "tqdm_remaining_seconds", "Estimated time until the progress bar reaches its total." },
+        { "tqdm_done", "Whether the progress bar is done." },
+    };
+    // room for one sample: metric name, labels and value
+    const size_t sample_size = 64 + 2 * TQDM_EXPORTER_LABEL_SIZE;
+
+    pthread_mutex_lock(&e->_mutex);
+    unsigned int num_bars = e->num_bars;
+    tqdm_stats stats[TQDM_EXPORTER_MAX_BARS];
+    for (unsigned int i = 0; i < num_bars; i++) {
+        tqdm_snapshot(e->bars[i], &stats[i]);
+    }
+
+    char *out = e->_buffer;
+    size_t len = 0;
+    for (unsigned int m = 0; m < sizeof(metrics) / sizeof(metrics[0]); m++) {
+        if (TQDM_EXPORTER_BUFFER_SIZE - len < 256) {
+            break;
+        }
+        len = _tqdm_exporter_append(out, len, "# HELP ", 7);
+        len = _tqdm_exporter_append(out, len, metrics[m][0], strlen(metrics[m][0]));
+        out[len++] = ' ';
+        len = _tqdm_exporter_append(out, len, metrics[m][1], strlen(metrics[m][1]));
+        len = _tqdm_exporter_append(out, len, "\n# TYPE ", 8);
+        len = _tqdm_exporter_append(out, len, metrics[m][0], strlen(metrics[m][0]));
+        len = _tqdm_exporter_append(out, len, " gauge\n", 7);
+
+        for (unsigned int i = 0; i < num_bars && TQDM_EXPORTER_BUFFER_SIZE - len >= sample_size; i++) {
+            const tqdm_stats *st = &stats[i];
+            bool known_total = st->total_steps != TQDM_UNKNOWN_TOTAL;
+            double value;
+            switch (m) {
+                case 0: value = (double)st->current_steps; break;
+                case 1: value = known_total ? (double)st->total_steps : -1; break;
+                case 2: value = st->elapsed; break;
+                case 3: value = st->rate; break;
+                case 4: value = st->remaining; break;
+                default: value = st->done; break;
+            }
+            if (value < 0) {
+                continue;
+            }
+
+            // escape the description as a label value
+            char label[2 * TQDM_EXPORTER_LABEL_SIZE];
+            const char *d = e->bars[i]->description;
+            size_t label_length = 0;
+            for (size_t k = 0; k < TQDM_EXPORTER_LABEL_SIZE && d[k] != '\0'; k++) {
+                if (d[k] == '\\' || d[k] == '"') {
+                    label[label_length++] = '\\';
+                    label[label_length++] = d[k];
+                } else if (d[k] == '\n') {
+                    label[label_length++] = '\\';
+                    label[label_length++] = 'n';
+                } else {
+                    label[label_length++] = d[k];
+                }
+            }
+
+            // counts are exact integers, the rest are rounded to two decimals
+            len = _tqdm_exporter_sample(out, len, metrics[m][0], i, label, label_length, value,
+                                        m == 0 || m == 1 || m == 5);
+        }
+    }
+    pthread_mutex_unlock(&e->_mutex);
+    return len;
+}
+
+/// helper to replace the textfile atomically with the current metrics, so readers never see half of it
+static void _tqdm_exporter_write_textfile(tqdm_exporter *e) {
+    size_t len = _tqdm_exporter_format(e);
+
+    char tmp[4096];
+    size_t path_length = strnlen(e->textfile_path, sizeof(tmp) - 8);
+    memcpy(tmp, e->textfile_path, path_length);
+    memcpy(tmp + path_length, ".tmp", 5);
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return;
+    }
+    bool ok = write(fd, e->_buffer, len) == (ssize_t)len;
+    close(fd);
+    if (!ok || rename(tmp, e->textfile_path) != 0) {
+        unlink(tmp);
+    }
+}
+
+/// helper to send a whole buffer on a socket, returning false if the peer has gone away
+static bool _tqdm_exporter_send(int fd, const char *p, size_t n) {
+    while (n > 0) {
+        // MSG_NOSIGNAL so that a client closing early doesn't raise SIGPIPE in the host process
+        ssize_t sent = send(fd, p, n, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += sent;
+        n -= sent;
+    }
+    return true;
+}
+
+/// helper to answer one connection on the Unix socket with the current metrics over HTTP
+static void _tqdm_exporter_serve(tqdm_exporter *e) {
+#ifdef _GNU_SOURCE
+    int fd = accept4(e->_listen_fd, NULL, NULL, SOCK_CLOEXEC);
+#else
+    // accept4 is only declared with _GNU_SOURCE
+    int fd = accept(e->_listen_fd, NULL, NULL);
+    if (fd >= 0) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+#endif // _GNU_SOURCE
+    if (fd < 0) {
+        return;
+    }
+
+    // the request itself doesn't matter: every path serves the metrics
+    char request[1024];
+    struct pollfd p = { fd, POLLIN, 0 };
+    if (poll(&p, 1, 100) > 0) {
+        read(fd, request, sizeof(request));
+    }
+
+    static const char header[] = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n\r\n";
+    size_t len = _tqdm_exporter_format(e);
+    if (_tqdm_exporter_send(fd, header, sizeof(header) - 1)) {
+        _tqdm_exporter_send(fd, e->_buffer, len);
+    }
+    close(fd);
+}
+
+/// entry point of the exporter thread
+static void *_tqdm_exporter_main(void *arg) {
+    tqdm_exporter *e = (tqdm_exporter *)arg;
+    long next_ms = _tqdm_now_ms();
+
+    for (;;) {
+        long now_ms = _tqdm_now_ms();
+        if (e->textfile_path && now_ms >= next_ms) {
+            _tqdm_exporter_write_textfile(e);
+            next_ms = now_ms + MAX(e->interval_ms, 1);
+        }
+
+        // sleep until the next textfile update, a connection, or tqdm_exporter_stop
+        struct pollfd fds[2] = { { e->_wake[0], POLLIN, 0 }, { e->_listen_fd, POLLIN, 0 } };
+        int timeout = e->textfile_path ? (int)MAX(next_ms - _tqdm_now_ms(), 0) : -1;
+        if (poll(fds, e->_listen_fd >= 0 ? 2 : 1, timeout) < 0 && errno != EINTR) {
+            break;
+        }
+        if (fds[0].revents) {
+            break;
+        }
+        if (e->_listen_fd >= 0 && (fds[1].revents & POLLIN)) {
+            _tqdm_exporter_serve(e);
+        }
+    }
+
+    // leave the final state of the bars behind
+    if (e->textfile_path) {
+        _tqdm_exporter_write_textfile(e);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Start exporting bars from a background thread
+ *
+ * Must be called after setting `textfile_path` and/or `socket_path`. A stale
+ * socket file at `socket_path` is replaced. Served metrics can be read with
+ * e.g. `curl --unix-socket <socket_path> http://localhost/metrics`.
+ *
+ * @param e Pointer to tqdm_exporter struct to start
+ * @return 0 on success, or an error number if the socket or thread could not be created
+ */
+static inline int tqdm_exporter_start(tqdm_exporter *e) {
+    if (pipe(e->_wake) != 0) {
+        return errno;
+    }
+
+    int err = 0;
+    if (e->socket_path) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        size_t path_length = strlen(e->socket_path);
+        if (path_length >= sizeof(addr.sun_path)) {
+            err = ENAMETOOLONG;
+        } else {
+            memcpy(addr.sun_path, e->socket_path, path_length);
+            e->_listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            unlink(e->socket_path);
+            if (e->_listen_fd < 0 ||
+                bind(e->_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+                listen(e->_listen_fd, 16) != 0) {
+                err = errno;
+            }
+        }
+    }
+    if (err == 0) {
+        err = pthread_create(&e->_thread, NULL, _tqdm_exporter_main, e);
+    }
+
+    if (err != 0) {
+        if (e->_listen_fd >= 0) {
+            close(e->_listen_fd);
+            e->_listen_fd = -1;
+        }
+        close(e->_wake[0]);
+        close(e->_wake[1]);
+        e->_wake[0] = e->_wake[1] = -1;
+    }
+    return err;
+}
+
+/**
+ * @brief Stop an exporter, writing the textfile one last time and removing the socket
+ *
+ * @param e Pointer to tqdm_exporter struct to stop
+ */
+static inline void tqdm_exporter_stop(tqdm_exporter *e) {
+    if (e->_wake[1] >= 0) {
+        write(e->_wake[1], "", 1);
+        pthread_join(e->_thread, NULL);
+        close(e->_wake[0]);
+        close(e->_wake[1]);
+        e->_wake[0] = e->_wake[1] = -1;
+    }
+    if (e->_listen_fd >= 0) {
+        close(e->_listen_fd);
+        e->_listen_fd = -1;
+        unlink(e->socket_path);
+    }
+    pthread_mutex_destroy(&e->_mutex);
+}
+#endif // TQDM_THREADS
+
+/**
+ * @brief Helper to find where the next chunk of a strip-mined loop ends
+ *
+ * Chunks are sized to the number of steps between clock reads, which adapts
+ * to the measured iteration rate, so the loop calls tqdm_update about once per
+ * clock read. Once the bar is done or disabled, the rest of the range is run
+ * as a single chunk.
+ */
+static inline uint64_t _tqdm_chunk_end(const tqdm *t, uint64_t chunk_start, uint64_t end) {
+    uint64_t size = t->_done ? UINT64_MAX : (t->miniters ? t->miniters : t->_miniters);
+    return end - chunk_start > size ? chunk_start + size : end;
+}
+
+/**
+ * @brief Helper to close the bar of a loop macro, in case the loop was left early
+ *
+ * A bar left short of its total by `break` would otherwise never end its line
+ * or give back its registry slot. Bars that were never drawn have neither.
+ */
+static inline void _tqdm_close_early(tqdm *t) {
+    if (t->_drawn && !t->_closed) {
+        tqdm_close(t);
+    }
+}
+
+#if TQDM_DISABLE
+/* ==================== compile-out ==================== */
+
+// replace every entry point with a no-op that still evaluates its arguments
+#define tqdm_init(t, total_steps, description, min_interval_ms) \
+    ((void)(t), (void)(total_steps), (void)(description), (void)(min_interval_ms))
+#define tqdm_update(t, step) ((void)(t), (void)(step))
+#define tqdm_update_concurrent(t, step) ((void)(t), (void)(step))
+#define tqdm_close(t) ((void)(t))
+#define tqdm_render(t, width, buffer, size) \
+    ((void)(t), (void)(width), (size) > 0 ? (void)(((char *)(buffer))[0] = '\0') : (void)0, (size_t)0)
+#define tqdm_snapshot(t, stats) ((void)(t), (void)memset((stats), 0, sizeof(tqdm_stats)))
+#define tqdm_manager_init(m, min_interval_ms) ((void)(m), (void)(min_interval_ms))
+#define tqdm_manager_add(m, t) ((void)(m), (void)(t), true)
+#define tqdm_manager_close(m) ((void)(m))
+#define tqdm_init_child(t, parent, total_steps, description, leave) \
+    ((void)(t), (void)(parent), (void)(total_steps), (void)(description), (void)(leave), true)
+#define tqdm_sharded_init(ts, total_steps, description, min_interval_ms) \
+    ((void)(ts), (void)(total_steps), (void)(description), (void)(min_interval_ms))
+#define tqdm_sharded_update(ts, step) ((void)(ts), (void)(step))
+#define tqdm_sharded_close(ts) ((void)(ts))
+// shared bars are replaced by a dummy so that the returned pointer is not NULL
+static tqdm _tqdm_disabled_shared __attribute__((unused));
+#define tqdm_shared_create(total_steps, description, min_interval_ms) \
+    ((void)(total_steps), (void)(description), (void)(min_interval_ms), &_tqdm_disabled_shared)
+#define tqdm_shared_update(t, step) ((void)(t), (void)(step))
+#define tqdm_shared_refresh(t) ((void)(t))
+#define tqdm_shared_close(t) ((void)(t))
+#if TQDM_THREADS
+#define tqdm_renderer_start(r, t) ((void)(r), (void)(t), 0)
+#define tqdm_renderer_stop(r) ((void)(r))
+#define tqdm_monitor_start(r, t, counter) ((void)(r), (void)(t), (void)(counter), 0)
+#define tqdm_exporter_init(e, interval_ms) ((void)(e), (void)(interval_ms))
+#define tqdm_exporter_add(e, t) ((void)(e), (void)(t), true)
+#define tqdm_exporter_start(e) ((void)(e), 0)
+#define tqdm_exporter_stop(e) ((void)(e))
+#endif // TQDM_THREADS
+#endif // TQDM_DISABLE
+
+/* ==================== convenience macros ==================== */
+
+/**
+ * @brief Pair of macros to create a for loop with an integrated tqdm progress bar
+ *
+ * @param var Loop variable
+ * @param start Starting value (inclusive)
+ * @param end Ending value (exclusive)
+ * @param desc Description string for progress bar
+ *
+ * Usage:
+ * ```
+ * int i;
+ * TQDM_FOR_BEGIN(i, 0, 10000, "Processing")
+ *     // loop body
+ * TQDM_FOR_END;
+ * ```
+ */
+#if TQDM_DISABLE
+#define TQDM_FOR_BEGIN(var, start, end, desc)                       \
+    do {                                                            \
+        (void)(desc);                                               \
+        for (uint64_t var = (start); var < (end); ++var) {
+
+#define TQDM_FOR_END                                                \
+        }                                                           \
+    } while (0)
+#else
+#define TQDM_FOR_BEGIN(var, start, end, desc)                       \
+    do {                                                            \
+        tqdm _tqdm;                                                 \
+        tqdm_init(&_tqdm, (end) - (start), (desc), 50);             \
+        for (uint64_t var = (start); var < (end); ++var) {
+
+#define TQDM_FOR_END                                                \
+            tqdm_update(&_tqdm, 1);                                 \
+        }                                                           \
+        _tqdm_close_early(&_tqdm);                                  \
+    } while (0)
+#endif // TQDM_DISABLE
+
+/**
+ * @brief Pair of macros to iterate over a range[0, n) with an integrated tqdm progress bar
+ *
+ * @param n Number of iterations
+ *
+ * Usage:
+ * ```
+ * TQDM_TRANGE(10000)
+ *     // loop body
+ * TQDM_END_TRANGE;
+ * ```
+ */
+#if TQDM_DISABLE
+#define TQDM_TRANGE(n)                                              \
+    do {                                                            \
+        for (uint64_t _tqdm_i = 0; _tqdm_i < (n); ++_tqdm_i) {
+
+#define TQDM_END_TRANGE                                             \
+        }                                                           \
+    } while (0)
+#else
+#define TQDM_TRANGE(n)                                              \
+    do {                                                            \
+        tqdm _tqdm;                                                 \
+        tqdm_init(&_tqdm, (n), "Processing", 50);                   \
+        for (uint64_t _tqdm_i = 0; _tqdm_i < (n); ++_tqdm_i) {
+
+#define TQDM_END_TRANGE                                             \
+            tqdm_update(&_tqdm, 1);                                 \
+        }                                                           \
+        _tqdm_close_early(&_tqdm);                                  \
+    } while (0)
+#endif // TQDM_DISABLE
+
+/**
+ * @brief Pair of macros to create a strip-mined for loop with an integrated tqdm progress bar
+ *
+ * Runs the range as a sequence of plain inner loops over chunks of iterations,
+ * calling tqdm_update once per chunk, so that the loop body can be vectorised
+ * and unrolled. The chunk size is chosen automatically from the measured
+ * iteration rate. Since `break` would only leave the current chunk, the loop
+ * body must not use it.
+ *
+ * @param var Loop variable
+ * @param start Starting value (inclusive)
+ * @param end Ending value (exclusive)
+ * @param desc Description string for progress bar
+ *
+ * Usage:
+ * ```
+ * TQDM_FOR_CHUNKED_BEGIN(i, 0, n, "Summing")
+ *     sum += a[i] * b[i];
+ * TQDM_FOR_CHUNKED_END;
+ * ```
+ */
+#if TQDM_DISABLE
+#define TQDM_FOR_CHUNKED_BEGIN(var, start, end, desc)              \
+    TQDM_FOR_BEGIN(var, start, end, desc)
+
+#define TQDM_FOR_CHUNKED_END                                        \
+    TQDM_FOR_END
+#else
+#define TQDM_FOR_CHUNKED_BEGIN(var, start, end, desc)              \
+    do {                                                            \
+        tqdm _tqdm;                                                 \
+        tqdm_init(&_tqdm, (end) - (start), (desc), 50);             \
+        uint64_t _tqdm_end = (end);                                 \
+        for (uint64_t _tqdm_chunk = (start), _tqdm_limit;           \
+             _tqdm_chunk < _tqdm_end;                               \
+             tqdm_update(&_tqdm, _tqdm_limit - _tqdm_chunk),        \
+             _tqdm_chunk = _tqdm_limit) {                           \
+            _tqdm_limit = _tqdm_chunk_end(&_tqdm, _tqdm_chunk, _tqdm_end); \
+            for (uint64_t var = _tqdm_chunk; var < _tqdm_limit; ++var) {
+
+#define TQDM_FOR_CHUNKED_END                                        \
+            }                                                       \
+        }                                                           \
+    } while (0)
+#endif // TQDM_DISABLE
+
+/**
+ * @brief Pair of macros to iterate over a range [0, n) in chunks with an integrated tqdm progress bar
+ *
+ * Strip-mined counterpart of TQDM_TRANGE; see TQDM_FOR_CHUNKED_BEGIN.
+ *
+ * @param n Number of iterations
+ *
+ * Usage:
+ * ```
+ * TQDM_TRANGE_CHUNKED(10000)
+ *     // loop body
+ * TQDM_END_TRANGE_CHUNKED;
+ * ```
+ */
+#if TQDM_DISABLE
+#define TQDM_TRANGE_CHUNKED(n)                                      \
+    TQDM_TRANGE(n)
+
+#define TQDM_END_TRANGE_CHUNKED                                     \
+    TQDM_END_TRANGE
+#else
+#define TQDM_TRANGE_CHUNKED(n)                                      \
+    TQDM_FOR_CHUNKED_BEGIN(_tqdm_i, 0, (n), "Processing")
+
+#define TQDM_END_TRANGE_CHUNKED                                     \
+    TQDM_FOR_CHUNKED_END
+#endif // TQDM_DISABLE
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#if defined(__cplusplus) && TQDM_THREADS && !TQDM_DISABLE
+#include <atomic>
+
+/// overload of tqdm_monitor_start for counters held in a std::atomic
+static inline int tqdm_monitor_start(tqdm_renderer *r, tqdm *t, const std::atomic<uint64_t> *counter) {
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+                  "std::atomic<uint64_t> must have the layout of uint64_t");
+    return tqdm_monitor_start(r, t, reinterpret_cast<const uint64_t *>(counter));
+}
+#endif // __cplusplus && TQDM_THREADS && !TQDM_DISABLE
 
 #endif // TQDM_H
\ No newline at end of file
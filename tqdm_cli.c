@@ -0,0 +1,310 @@
+#define _GNU_SOURCE // for splice and tee
+#include "tqdm.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// copies stdin to stdout while showing the throughput on stderr, like pv
+//
+// build with: cc -O2 -o tqdm tqdm_cli.c
+// usage: tqdm [-l] [-s size] [-d description] [-i interval_ms] < in > out
+
+/// number of bytes moved per system call
+#define CHUNK_SIZE (1 << 20)
+
+static const char *usage =
+    "usage: tqdm [-l] [-s size] [-d description] [-i interval_ms]\n"
+    "copies stdin to stdout, showing progress on stderr\n"
+    "  -l  count lines instead of bytes\n"
+    "  -s  expected total, in bytes or lines (K, M, G and T suffixes are powers of 1024\n"
+    "      for bytes and of 1000 for lines, as the bar shows them)\n"
+    "  -d  description shown before the bar\n"
+    "  -i  minimum interval between redraws in milliseconds (default 100)\n";
+
+/* ==================== newline counting ==================== */
+
+/// helper to count the newlines in a buffer one byte at a time
+static uint64_t count_newlines_scalar(const char *p, size_t n) {
+    uint64_t count = 0;
+    const char *end = p + n;
+    while ((p = memchr(p, '\n', end - p)) != NULL) {
+        count++;
+        p++;
+    }
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/// helper to count the newlines in a buffer 32 bytes at a time
+__attribute__((target("avx2")))
+static uint64_t count_newlines_avx2(const char *p, size_t n) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    uint64_t count = 0;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(p + i));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline));
+        count += __builtin_popcount(mask);
+    }
+    return count + count_newlines_scalar(p + i, n - i);
+}
+
+/// helper to count the newlines in a buffer 16 bytes at a time
+__attribute__((target("sse2")))
+static uint64_t count_newlines_sse2(const char *p, size_t n) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    uint64_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(p + i));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        count += __builtin_popcount(mask);
+    }
+    return count + count_newlines_scalar(p + i, n - i);
+}
+#endif
+
+/// helper to count the newlines in a buffer with the widest vector instructions available
+static uint64_t count_newlines(const char *p, size_t n) {
+#if defined(__x86_64__) || defined(__i386__)
+    static int has_avx2 = -1;
+    if (has_avx2 < 0) {
+        __builtin_cpu_init();
+        has_avx2 = __builtin_cpu_supports("avx2");
+    }
+    return has_avx2 ? count_newlines_avx2(p, n) : count_newlines_sse2(p, n);
+#else
+    return count_newlines_scalar(p, n);
+#endif
+}
+
+/* ==================== copying ==================== */
+
+/// helper to write a whole buffer, returning false on error
+static bool write_all(int fd, const char *p, size_t n) {
+    while (n > 0) {
+        ssize_t written = write(fd, p, n);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += written;
+        n -= written;
+    }
+    return true;
+}
+
+/**
+ * @brief Copy stdin to stdout with splice, without copying data through user space
+ *
+ * @return 1 on success, 0 if splice is not supported between the two ends
+ *         before anything was copied, or -1 on error
+ */
+static int copy_splice(tqdm *bar) {
+    bool started = false;
+    for (;;) {
+        ssize_t n = splice(STDIN_FILENO, NULL, STDOUT_FILENO, NULL, CHUNK_SIZE, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return !started && errno == EINVAL ? 0 : -1;
+        }
+        if (n == 0) {
+            return 1;
+        }
+        started = true;
+        tqdm_update(bar, n);
+    }
+}
+
+/**
+ * @brief Copy stdin to stdout with tee, counting newlines in the data as it is consumed
+ *
+ * tee duplicates the data into stdout without consuming it, so it is then
+ * read from stdin to be counted: one copy into user space instead of two.
+ *
+ * @return 1 on success, 0 if tee is not supported between the two ends
+ *         before anything was copied, or -1 on error
+ */
+static int copy_tee_lines(tqdm *bar, char *buffer) {
+    bool started = false;
+    for (;;) {
+        ssize_t n = tee(STDIN_FILENO, STDOUT_FILENO, CHUNK_SIZE, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return !started && errno == EINVAL ? 0 : -1;
+        }
+        if (n == 0) {
+            return 1;
+        }
+        started = true;
+
+        // consume exactly the bytes that were duplicated
+        while (n > 0) {
+            ssize_t got = read(STDIN_FILENO, buffer, n);
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                return -1;
+            }
+            tqdm_update(bar, count_newlines(buffer, got));
+            n -= got;
+        }
+    }
+}
+
+/// helper to copy stdin to stdout through a buffer, returning false on error
+static bool copy_read_write(tqdm *bar, char *buffer, bool lines) {
+    for (;;) {
+        ssize_t n = read(STDIN_FILENO, buffer, CHUNK_SIZE);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (n == 0) {
+            return true;
+        }
+        if (!write_all(STDOUT_FILENO, buffer, n)) {
+            return false;
+        }
+        tqdm_update(bar, lines ? count_newlines(buffer, n) : (uint64_t)n);
+    }
+}
+
+/// helper to parse a size with an optional K, M, G or T suffix, each a power of `divisor`,
+/// returning false if it is invalid
+static bool parse_size(const char *s, uint32_t divisor, uint64_t *size) {
+    char *end;
+    errno = 0;
+    unsigned long long v = strtoull(s, &end, 10);
+    // strtoull accepts a sign and negates the value
+    if (errno != 0 || end == s || strchr(s, '-') != NULL) {
+        return false;
+    }
+
+    int power = 0;
+    switch (*end) {
+        case 'T': case 't': power++; // fallthrough
+        case 'G': case 'g': power++; // fallthrough
+        case 'M': case 'm': power++; // fallthrough
+        case 'K': case 'k': power++; end++; break;
+        default: break;
+    }
+    if (*end != '\0') {
+        return false;
+    }
+    for (; power > 0; power--) {
+        if (v > UINT64_MAX / divisor) {
+            return false;
+        }
+        v *= divisor;
+    }
+    *size = (uint64_t)v;
+    return true;
+}
+
+/// helper to parse an interval in milliseconds, returning false if it is invalid
+static bool parse_interval(const char *s, uint32_t *interval_ms) {
+    char *end;
+    errno = 0;
+    unsigned long long v = strtoull(s, &end, 10);
+    if (errno != 0 || end == s || *end != '\0' || strchr(s, '-') != NULL || v > UINT32_MAX) {
+        return false;
+    }
+    *interval_ms = (uint32_t)v;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    bool lines = false;
+    uint64_t total = TQDM_UNKNOWN_TOTAL;
+    const char *size = NULL;
+    const char *description = NULL;
+    uint32_t interval_ms = 100;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "ls:d:i:h")) != -1) {
+        switch (opt) {
+            case 'l':
+                lines = true;
+                break;
+            case 's':
+                size = optarg;
+                break;
+            case 'd':
+                description = optarg;
+                break;
+            case 'i':
+                if (!parse_interval(optarg, &interval_ms)) {
+                    fprintf(stderr, "tqdm: invalid interval '%s'\n", optarg);
+                    return 2;
+                }
+                break;
+            default:
+                fputs(usage, opt == 'h' ? stdout : stderr);
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind != argc) {
+        fputs(usage, stderr);
+        return 2;
+    }
+    // parsed once all options are known, as the suffixes depend on -l
+    if (size != NULL && !parse_size(size, lines ? 1000 : 1024, &total)) {
+        fprintf(stderr, "tqdm: invalid size '%s'\n", size);
+        return 2;
+    }
+
+    // the size of a regular file being read is the total number of bytes
+    struct stat st;
+    if (!lines && total == TQDM_UNKNOWN_TOTAL && fstat(STDIN_FILENO, &st) == 0 &&
+        S_ISREG(st.st_mode)) {
+        off_t offset = lseek(STDIN_FILENO, 0, SEEK_CUR);
+        // nothing is left to read if stdin is positioned at or past the end of the file
+        total = offset < st.st_size ? (uint64_t)(st.st_size - MAX(offset, 0)) : 0;
+    }
+
+    tqdm bar;
+    tqdm_init(&bar, total, description, interval_ms);
+    bar.unit_scale = true;
+    if (lines) {
+        bar.unit = "lines";
+    } else {
+        bar.unit = "B";
+        bar.unit_divisor = 1024;
+    }
+
+    // report a closed pipe downstream as EPIPE, so that the bar is closed on the way out
+    signal(SIGPIPE, SIG_IGN);
+
+    static char buffer[CHUNK_SIZE];
+    int result = lines ? copy_tee_lines(&bar, buffer) : copy_splice(&bar);
+    bool ok = result > 0 || (result == 0 && copy_read_write(&bar, buffer, lines));
+    int error = errno;
+    tqdm_close(&bar);
+
+    if (!ok) {
+        // a closed pipe downstream is the reader's choice, not an error
+        if (error == EPIPE) {
+            return 0;
+        }
+        fprintf(stderr, "tqdm: %s\n", strerror(error));
+        return 1;
+    }
+    return 0;
+}
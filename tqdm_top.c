@@ -0,0 +1,169 @@
+#define TQDM_REGISTRY 1
+#include "tqdm.h"
+
+#include <dirent.h>
+#include <errno.h>
+
+// shows every progress bar published to the registry on this machine, like top
+//
+// programs publish their bars when built with -DTQDM_REGISTRY=1
+// build with: cc -O2 -o tqdm-top tqdm_top.c
+// usage: tqdm-top [-1] [-H] [-i interval_ms] [-s stall_s]
+
+static const char *usage =
+    "usage: tqdm-top [-1] [-H] [-i interval_ms] [-s stall_s]\n"
+    "shows the progress bars published by programs built with -DTQDM_REGISTRY=1\n"
+    "  -1  print the bars once and exit\n"
+    "  -H  hide stalled bars instead of marking them\n"
+    "  -i  interval between refreshes in milliseconds (default 1000)\n"
+    "  -s  seconds without a redraw after which a bar is stalled (default 60)\n";
+
+/// time in ms without a redraw after which a bar is shown as stalled
+static long stall_ms = 60000;
+/// whether stalled bars are hidden rather than marked
+static bool hide_stalled = false;
+
+/// helper to map the registry segment of a process read-only, returning NULL if it is not valid
+static const tqdm_registry *map_segment(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    void *p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(tqdm_registry)) {
+        p = mmap(NULL, sizeof(tqdm_registry), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+
+    const tqdm_registry *r = (const tqdm_registry *)p;
+    if (__atomic_load_n(&r->magic, __ATOMIC_ACQUIRE) != TQDM_REGISTRY_MAGIC ||
+        r->num_slots != TQDM_REGISTRY_SLOTS) {
+        munmap(p, sizeof(tqdm_registry));
+        return NULL;
+    }
+    return r;
+}
+
+/// helper to print every bar of one segment, returning the number of bars printed
+static unsigned int print_segment(const tqdm_registry *r, unsigned int width) {
+    unsigned int printed = 0;
+    char line[TQDM_MAXIMUM_LINE_SIZE];
+    char stalled[32];
+    long now_ms = _tqdm_now_ms();
+
+    for (unsigned int i = 0; i < TQDM_REGISTRY_SLOTS; i++) {
+        tqdm_registry_slot slot;
+        if (!tqdm_registry_read(&r->slots[i], &slot)) {
+            continue;
+        }
+
+        // a bar that has not been redrawn for a while is stuck, or was abandoned without
+        // being closed, and keeps its slot until its process exits
+        long idle_ms = now_ms - (long)slot.update_ms;
+        size_t suffix = 0;
+        if (idle_ms >= stall_ms) {
+            if (hide_stalled) {
+                continue;
+            }
+            memcpy(stalled, "  stalled ", 10);
+            suffix = 10 + _tqdm_format_time(stalled + 10, idle_ms);
+        }
+        stalled[suffix] = '\0';
+
+        // render the published state as a bar started at the same time, with its elapsed
+        // time and rate frozen at its last redraw if it has stalled
+        tqdm bar;
+        tqdm_init(&bar, slot.total_steps, slot.description, 0);
+        bar.current_steps = slot.current_steps;
+        bar._start = (long)slot.start_ms + (suffix > 0 ? idle_ms : 0);
+        bar.eta_model = &tqdm_eta_average;
+
+        unsigned int columns = printf("%7lld  ", (long long)r->pid) + suffix;
+        tqdm_render(&bar, width > columns ? width - columns : 0, line, sizeof(line));
+        printf("%s%s\n", line, stalled);
+        printed++;
+    }
+    return printed;
+}
+
+/// helper to print the bars of every process on the machine, returning the number printed
+static unsigned int print_all(unsigned int width) {
+    DIR *dir = opendir(TQDM_REGISTRY_DIR);
+    if (dir == NULL) {
+        return 0;
+    }
+
+    unsigned int printed = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "tqdm.", 5) != 0) {
+            continue;
+        }
+        char path[sizeof(TQDM_REGISTRY_DIR) + sizeof(entry->d_name)];
+        snprintf(path, sizeof(path), "%s/%s", TQDM_REGISTRY_DIR, entry->d_name);
+
+        const tqdm_registry *r = map_segment(path);
+        if (r == NULL) {
+            continue;
+        }
+        if (kill((pid_t)r->pid, 0) != 0 && errno == ESRCH) {
+            // left behind by a process that exited without cleaning up
+            unlink(path);
+        } else {
+            printed += print_segment(r, width);
+        }
+        munmap((void *)r, sizeof(tqdm_registry));
+    }
+    closedir(dir);
+    return printed;
+}
+
+int main(int argc, char **argv) {
+    bool once = false;
+    long interval_ms = 1000;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "1Hi:s:h")) != -1) {
+        switch (opt) {
+            case '1':
+                once = true;
+                break;
+            case 'H':
+                hide_stalled = true;
+                break;
+            case 'i':
+                interval_ms = MAX(strtol(optarg, NULL, 10), 1);
+                break;
+            case 's':
+                stall_ms = MAX(strtol(optarg, NULL, 10), 1) * 1000;
+                break;
+            default:
+                fputs(usage, opt == 'h' ? stdout : stderr);
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    // measure the terminal the bars are printed to
+    tqdm out;
+    tqdm_init(&out, 0, NULL, 0);
+    out._fd = STDOUT_FILENO;
+
+    for (;;) {
+        if (!once) {
+            // move to the top of a cleared screen
+            fputs("\033[H\033[2J", stdout);
+        }
+        if (print_all(_tqdm_terminal_size(&out)) == 0) {
+            puts("no progress bars");
+        }
+        fflush(stdout);
+        if (once) {
+            return 0;
+        }
+        usleep(interval_ms * 1000);
+    }
+}